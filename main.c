@@ -5,6 +5,16 @@
 #include <oct/cJSON.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <threads.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 ///////////////////////// ENUMS /////////////////////////
 typedef enum {
@@ -72,17 +82,151 @@ typedef enum {
     STARTING_MAP_MAX = 3
 } StartingMap;
 
+// Bits of FrameInput::buttons
+typedef enum {
+    INPUT_LEFT = 1 << 0, // held
+    INPUT_RIGHT = 1 << 1, // held
+    INPUT_JUMP = 1 << 2, // pressed
+    INPUT_ACTION = 1 << 3, // pressed
+    INPUT_CONFIRM = 1 << 4, // space pressed, leaves the death screen
+    INPUT_QUIT = 1 << 5, // debug, straight back to the menu
+    INPUT_SPAWN_DASHER = 1 << 6, // debug
+    INPUT_SPAWN_LASER = 1 << 7, // debug
+    INPUT_SPAWN_BOMBER = 1 << 8, // debug
+} InputButton;
+
+// What a tile does to things touching it, see TILE_FLAGS
+typedef enum {
+    TILE_FLAG_SOLID = 1 << 0, // anything non-empty
+    TILE_FLAG_BOUNCY = 1 << 1, // rebounds harder and makes the bump sound
+    TILE_FLAG_ICE = 1 << 2, // no ground friction
+    TILE_FLAG_AI_INVISIBLE = 1 << 3, // only the player collides with it
+} TileFlag;
+
+// Independent random sequences so cosmetic stuff can't change how a run plays out
+typedef enum {
+    RNG_STREAM_AI, // ai decisions and gameplay rolls like the jumper stomp fling
+    RNG_STREAM_SPAWN, // what enemies spawn and where
+    RNG_STREAM_COSMETIC, // particles and music
+    RNG_STREAM_MAX,
+} RngStream;
+
+typedef enum {
+    REPLAY_MODE_OFF,
+    REPLAY_MODE_RECORDING, // every game_update's input is kept and saved when the first game ends
+    REPLAY_MODE_PLAYING, // input comes from the replay instead of the keyboard/gamepad
+} ReplayMode;
+
+// Parts of the game hashed separately every frame so a desync can say where it started
+typedef enum {
+    STATE_HASH_GAME, // timers, score, kills, phase, rng
+    STATE_HASH_POOLS, // which slots are alive and their generations
+    STATE_HASH_CHARACTERS,
+    STATE_HASH_PROJECTILES,
+    STATE_HASH_PARTICLES,
+    STATE_HASH_MAX,
+} StateHashPart;
+
+// Parts of a frame the profiler times
+typedef enum {
+    PROFILE_PHASE_CHARACTERS,
+    PROFILE_PHASE_PROJECTILES,
+    PROFILE_PHASE_PARTICLES,
+    PROFILE_PHASE_SPAWNS,
+    PROFILE_PHASE_HUD, // kill bar, time bar and score
+    PROFILE_PHASE_BLIT, // backbuffer to window
+    PROFILE_PHASE_FRAME, // all of update
+    PROFILE_PHASE_MAX,
+} ProfilePhase;
+
+// Index into gAssets
+typedef enum {
+    ASSET_FNT_KINGDOM,
+    ASSET_FNT_MONOGRAM,
+    ASSET_TEX_100KPOINTS,
+    ASSET_TEX_10KPOINTS,
+    ASSET_TEX_200KPOINTS,
+    ASSET_TEX_20KPOINTS,
+    ASSET_TEX_40KPOINTS,
+    ASSET_TEX_5KPOINTS,
+    ASSET_TEX_ANGRY,
+    ASSET_TEX_BG1,
+    ASSET_TEX_BG2,
+    ASSET_TEX_BG3,
+    ASSET_TEX_BLOOD,
+    ASSET_TEX_BULLET,
+    ASSET_TEX_CLOCK,
+    ASSET_TEX_CLOCKHAND,
+    ASSET_TEX_CONTROLS,
+    ASSET_TEX_COPYRIGHT,
+    ASSET_TEX_CURTAINS,
+    ASSET_TEX_DANGER,
+    ASSET_TEX_GARBAGEPARTICLE,
+    ASSET_TEX_GUN,
+    ASSET_TEX_HIGHSCORE,
+    ASSET_TEX_ITSOVER,
+    ASSET_TEX_JACKED,
+    ASSET_TEX_KILLCOUNT,
+    ASSET_TEX_KILLCOUNTEMPTY,
+    ASSET_TEX_LAZER,
+    ASSET_TEX_LOCKED,
+    ASSET_TEX_MAP1,
+    ASSET_TEX_MAP2,
+    ASSET_TEX_MAP3,
+    ASSET_TEX_MENUBG,
+    ASSET_TEX_POINTER,
+    ASSET_TEX_THUMBSUP,
+    ASSET_TEX_TILESET,
+    ASSET_TEX_TITLE,
+    ASSET_TEX_XYGUN,
+    ASSET_TEX_YGUN,
+    ASSET_SPR_BOMBER,
+    ASSET_SPR_DASHER,
+    ASSET_SPR_EXPLOSION,
+    ASSET_SPR_FIRE,
+    ASSET_SPR_JUMPER,
+    ASSET_SPR_KABOOM,
+    ASSET_SPR_LASER,
+    ASSET_SPR_PLAYERBOMBER,
+    ASSET_SPR_PLAYERDASHER,
+    ASSET_SPR_PLAYERJUMPER,
+    ASSET_SPR_PLAYERLASER,
+    ASSET_SPR_PLAYERLASEROPEN,
+    ASSET_SPR_PLAYERSHOOTER,
+    ASSET_SPR_SHOOTER,
+    ASSET_SND_BUMPWALL,
+    ASSET_SND_CURSOR,
+    ASSET_SND_DIE,
+    ASSET_SND_GUNSHOT,
+    ASSET_SND_JUMP,
+    ASSET_SND_JUMPENEMY,
+    ASSET_SND_KABOOM,
+    ASSET_SND_LASER,
+    ASSET_SND_OST1,
+    ASSET_SND_OST2,
+    ASSET_SND_OUTTATIME,
+    ASSET_SND_PUNCH,
+    ASSET_SND_SELECT,
+    ASSET_SND_STONELONG,
+    ASSET_SND_STONESHORT,
+    ASSET_SND_TITLE,
+    ASSET_SND_TRANSFORM,
+    ASSET_MAX,
+    ASSET_NONE = ASSET_MAX, // for particles and projectiles without one
+} AssetID;
+
 ///////////////////////// GLOBALS /////////////////////////
 Oct_AssetBundle gBundle;
-Oct_Allocator gAllocator;
+thread_local Oct_Allocator gAllocator; // each batch worker makes its own
 Oct_Allocator gFrameAllocator; // arena for frame-time allocations
 Oct_Texture gBackBuffer;
 uint64_t gFrameCounter = 9999;
-uint64_t gParticleIDs = 999999;
 float gSoundVolume = 1;
 float gMusicVolume = 1;
 bool gPixelPerfect;
 Oct_Sound gPlayingMusic;
+Oct_Asset gAssets[ASSET_MAX];
+bool gHeadless; // no window, renderer or audio, see run_headless
 
 ///////////////////////// CONSTANTS /////////////////////////
 
@@ -220,6 +364,33 @@ const int32_t TIME_BETWEEN_PHASES3[] = {
         30 * 20, // doesnt matter, its infinite
 };
 
+// TileFlags for each tile in the tileset by its tiled id, ids past the end are plain walls
+const uint8_t TILE_FLAGS[] = {
+        0, // empty
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY, // 2 - 8 are the bouncy blocks
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID | TILE_FLAG_BOUNCY,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID,
+        TILE_FLAG_SOLID | TILE_FLAG_ICE, // 20 ice
+        TILE_FLAG_SOLID | TILE_FLAG_AI_INVISIBLE, // 21 keeps the player in, the ai walks through it
+};
+const int32_t TILE_FLAGS_SIZE = sizeof(TILE_FLAGS) / sizeof(TILE_FLAGS[0]);
+
 const char * TOP_LEVEL_MENU[] = {
         "Play",
         "Settings",
@@ -255,6 +426,27 @@ const float MAP_UNLOCK_SCORES[] = {
 #define MAX_PROJECTILES 100
 #define MAX_PARTICLES 1000
 #define MAX_PHYSICS_OBJECTS (MAX_CHARACTERS + MAX_PROJECTILES) // particles noclip
+
+// only the benchmark counts collision tests, so particle jobs never race on the counter
+#ifdef JAMGAME_BENCHMARK
+#define COUNT_COLLISION_TESTS(state, n) ((state)->collision_tests += (n))
+#else
+#define COUNT_COLLISION_TESTS(state, n) ((void)0)
+#endif
+#define MAX_POOL_SIZE MAX_PARTICLES // biggest entity array
+#define POOL_WORDS ((MAX_POOL_SIZE + 63) / 64)
+#define PROFILE_HISTORY 256 // frames kept by the profiler
+#define BATCH_MAX_WORKERS 256
+#define PARTICLE_JOB_SIZE 64 // particles integrated per job
+#define REPLAY_HEADER_SIZE 24
+#define REPLAY_RUN_SIZE 5 // u16 frames, u16 buttons, i8 axis
+#define SNAPSHOT_HEADER_SIZE 12
+#define TILE_SIZE 16
+#define LEVEL_TILES (32 * 18) // LEVEL_WIDTH * LEVEL_HEIGHT
+#define PARTITION_CELL_SIZE TILE_SIZE // physics objects can't be bigger than this
+#define PARTITION_COLUMNS 32 // LEVEL_WIDTH
+#define PARTITION_ROWS 18 // LEVEL_HEIGHT
+#define MAX_CONTACT_NEIGHBOURS (MAX_PHYSICS_OBJECTS * (MAX_PHYSICS_OBJECTS - 1)) // every pair stored both ways
 const float GROUND_FRICTION = 0.07;
 const float AIR_FRICTION = 0.04;
 const float GRAVITY = 0.5;
@@ -265,6 +457,9 @@ const float PLAYER_JUMP_SPEED = 8;
 const float JUMPER_DESCEND_SPEED = 4.5; // how fast the player can descend as jumper
 const float PARTICLES_GROUND_IMPACT_SPEED = 6;
 const float SPEED_LIMIT = 12;
+const float GROUND_PROBE_DISTANCE = 2; // how far above something a character can be and still be standing on it
+const float CONTACT_MARGIN = 20; // how far boxes are grown for the contact list, more than anything moves in a frame (speed limit, gravity and a bounce)
+const float SWEEP_SKIN = 0.01; // gap left between a body and whatever it slides into so they never end up overlapping
 const float PLAYER_STARTING_LIFESPAN = 60; // seconds;
 const int32_t START_REQ_KILLS = 2;
 const int32_t REQ_KILLS_ACCUMULATOR = 3; // every x transforms the kills required goes up by 1
@@ -283,10 +478,114 @@ const float DASHER_FLING_Y_DISTANCE = 7;
 const float DASHER_FLING_X_DISTANCE = 10;
 const float BOMBER_BLAST_RADIUS = 80;
 const int32_t MOUTH_OPEN_DURATION = 8;
+const float LASER_LENGTH = 512;
+const float LASER_HALF_THICKNESS = 8; // how far either side of the beam it hits things
 const float FADE_IN_OUT_TIME = 1 * 30;
 const float TRANSFORM_INDICATE_TIME = 1.2;
 const float GLOBAL_MUSIC_VOLUME = 0.23;
 const char *SAVE_NAME = "save.json";
+const float HEADLESS_BULLET_WIDTH = 6; // textures/bullet.png, nothing is loaded in headless mode
+const float HEADLESS_BULLET_HEIGHT = 4;
+const int32_t BATCH_DEFAULT_FRAMES = 30 * 60 * 10; // 10 minutes of game time
+const uint64_t FIRST_ENTITY_ID = 999999; // entity interpolation ids start here so they stay clear of the hud's
+const char REPLAY_MAGIC[4] = {'D', 'C', 'R', 'P'};
+const uint8_t REPLAY_VERSION = 2; // 1 is still read, it just has no keyframes
+const int32_t REPLAY_KEYFRAME_INTERVAL = 30 * 10; // 10 seconds of game time
+const int32_t REPLAY_MAX_SPEED = 64; // game_updates per drawn frame when fast forwarding
+const uint8_t REPLAY_FLAG_TUTORIAL = 1 << 0;
+const uint8_t REPLAY_FLAG_HASHES = 1 << 1; // theres a StateHash for every frame after the keyframes
+const char SNAPSHOT_MAGIC[4] = {'D', 'C', 'S', 'S'};
+const uint8_t SNAPSHOT_VERSION = 3;
+const char *PROFILE_PHASE_NAMES[] = {
+        [PROFILE_PHASE_CHARACTERS] = "characters",
+        [PROFILE_PHASE_PROJECTILES] = "projectiles",
+        [PROFILE_PHASE_PARTICLES] = "particles",
+        [PROFILE_PHASE_SPAWNS] = "spawns",
+        [PROFILE_PHASE_HUD] = "hud",
+        [PROFILE_PHASE_BLIT] = "blit",
+        [PROFILE_PHASE_FRAME] = "frame",
+};
+const char *STATE_HASH_PART_NAMES[] = {
+        [STATE_HASH_GAME] = "game",
+        [STATE_HASH_POOLS] = "pools",
+        [STATE_HASH_CHARACTERS] = "characters",
+        [STATE_HASH_PROJECTILES] = "projectiles",
+        [STATE_HASH_PARTICLES] = "particles",
+};
+
+// Everything the game pulls out of the bundle, resolved once in startup
+const char *ASSET_NAMES[] = {
+        [ASSET_FNT_KINGDOM] = "fnt_kingdom",
+        [ASSET_FNT_MONOGRAM] = "fnt_monogram",
+        [ASSET_TEX_100KPOINTS] = "textures/100points.png",
+        [ASSET_TEX_10KPOINTS] = "textures/10kpoints.png",
+        [ASSET_TEX_200KPOINTS] = "textures/200kpoints.png",
+        [ASSET_TEX_20KPOINTS] = "textures/20kpoints.png",
+        [ASSET_TEX_40KPOINTS] = "textures/40kpoints.png",
+        [ASSET_TEX_5KPOINTS] = "textures/5kpoints.png",
+        [ASSET_TEX_ANGRY] = "textures/angry.png",
+        [ASSET_TEX_BG1] = "textures/bg1.png",
+        [ASSET_TEX_BG2] = "textures/bg2.png",
+        [ASSET_TEX_BG3] = "textures/bg3.png",
+        [ASSET_TEX_BLOOD] = "textures/blood.png",
+        [ASSET_TEX_BULLET] = "textures/bullet.png",
+        [ASSET_TEX_CLOCK] = "textures/clock.png",
+        [ASSET_TEX_CLOCKHAND] = "textures/clockhand.png",
+        [ASSET_TEX_CONTROLS] = "textures/controls.png",
+        [ASSET_TEX_COPYRIGHT] = "textures/copyright.png",
+        [ASSET_TEX_CURTAINS] = "textures/curtains.png",
+        [ASSET_TEX_DANGER] = "textures/danger.png",
+        [ASSET_TEX_GARBAGEPARTICLE] = "textures/garbageparticle.png",
+        [ASSET_TEX_GUN] = "textures/gun.png",
+        [ASSET_TEX_HIGHSCORE] = "textures/highscore.png",
+        [ASSET_TEX_ITSOVER] = "textures/itsover.png",
+        [ASSET_TEX_JACKED] = "textures/jacked.png",
+        [ASSET_TEX_KILLCOUNT] = "textures/killcount.png",
+        [ASSET_TEX_KILLCOUNTEMPTY] = "textures/killcountempty.png",
+        [ASSET_TEX_LAZER] = "textures/lazer.png",
+        [ASSET_TEX_LOCKED] = "textures/locked.png",
+        [ASSET_TEX_MAP1] = "textures/map1.png",
+        [ASSET_TEX_MAP2] = "textures/map2.png",
+        [ASSET_TEX_MAP3] = "textures/map3.png",
+        [ASSET_TEX_MENUBG] = "textures/menubg.png",
+        [ASSET_TEX_POINTER] = "textures/pointer.png",
+        [ASSET_TEX_THUMBSUP] = "textures/thumbsup.png",
+        [ASSET_TEX_TILESET] = "textures/tileset.png",
+        [ASSET_TEX_TITLE] = "textures/title.png",
+        [ASSET_TEX_XYGUN] = "textures/xygun.png",
+        [ASSET_TEX_YGUN] = "textures/ygun.png",
+        [ASSET_SPR_BOMBER] = "sprites/bomber.json",
+        [ASSET_SPR_DASHER] = "sprites/dasher.json",
+        [ASSET_SPR_EXPLOSION] = "sprites/explosion.json",
+        [ASSET_SPR_FIRE] = "sprites/fire.json",
+        [ASSET_SPR_JUMPER] = "sprites/jumper.json",
+        [ASSET_SPR_KABOOM] = "sprites/kaboom.json",
+        [ASSET_SPR_LASER] = "sprites/laser.json",
+        [ASSET_SPR_PLAYERBOMBER] = "sprites/playerbomber.json",
+        [ASSET_SPR_PLAYERDASHER] = "sprites/playerdasher.json",
+        [ASSET_SPR_PLAYERJUMPER] = "sprites/playerjumper.json",
+        [ASSET_SPR_PLAYERLASER] = "sprites/playerlaser.json",
+        [ASSET_SPR_PLAYERLASEROPEN] = "sprites/playerlaseropen.json",
+        [ASSET_SPR_PLAYERSHOOTER] = "sprites/playershooter.json",
+        [ASSET_SPR_SHOOTER] = "sprites/shooter.json",
+        [ASSET_SND_BUMPWALL] = "sounds/bumpwall.wav",
+        [ASSET_SND_CURSOR] = "sounds/cursor.wav",
+        [ASSET_SND_DIE] = "sounds/die.wav",
+        [ASSET_SND_GUNSHOT] = "sounds/gunshot.wav",
+        [ASSET_SND_JUMP] = "sounds/jump.wav",
+        [ASSET_SND_JUMPENEMY] = "sounds/jumpenemy.wav",
+        [ASSET_SND_KABOOM] = "sounds/kaboom.wav",
+        [ASSET_SND_LASER] = "sounds/laser.wav",
+        [ASSET_SND_OST1] = "sounds/ost1.ogg",
+        [ASSET_SND_OST2] = "sounds/ost2.ogg",
+        [ASSET_SND_OUTTATIME] = "sounds/outtatime.wav",
+        [ASSET_SND_PUNCH] = "sounds/punch.wav",
+        [ASSET_SND_SELECT] = "sounds/select.wav",
+        [ASSET_SND_STONELONG] = "sounds/stonelong.wav",
+        [ASSET_SND_STONESHORT] = "sounds/stoneshort.wav",
+        [ASSET_SND_TITLE] = "sounds/title.ogg",
+        [ASSET_SND_TRANSFORM] = "sounds/transform.wav",
+};
 
 ///////////////////////// STRUCTS /////////////////////////
 typedef struct Save_t {
@@ -314,26 +613,64 @@ typedef struct PhysicsObject_t {
     float bb_height;
 } PhysicsObject;
 
-/* TODO: This if comparing all entities turns out to suck
+// One tile-sized cell of the broadphase grid, objects are kept in an intrusive list
 typedef struct SpacePartition_t {
-    PhysicsObject *objects[MAX_PHYSICS_OBJECTS];
-    int32_t len; // how many physics objects here
+    int16_t head; // first physics object in this cell or -1
 } SpacePartition;
 
+// Uniform grid over the level, every character/projectile lives in the cell its top-left corner
+// is in. Physics objects are numbered characters first then projectiles (see partition_object).
 typedef struct GlobalSpacePartition_t {
-    SpacePartition *partitions;
-    int32_t width;
-    int32_t height;
-    float partition_width;
-    float partition_height;
-} GlobalSpacePartition_t;*/
+    SpacePartition partitions[PARTITION_COLUMNS * PARTITION_ROWS];
+    int16_t next[MAX_PHYSICS_OBJECTS];
+    int16_t prev[MAX_PHYSICS_OBJECTS];
+    int16_t cell[MAX_PHYSICS_OBJECTS]; // cell each object is currently linked into or -1
+} GlobalSpacePartition;
+
+// Every character-character and character-projectile pair whose boxes grown by CONTACT_MARGIN overlapped
+// when the list was built at the start of the frame, found by sorting on x and sweeping. Since nothing
+// moves further than the margin in a frame an object's neighbours are all it can touch inside its
+// grown box for the rest of the frame (see contact_candidates).
+typedef struct ContactList_t {
+    int32_t start[MAX_PHYSICS_OBJECTS + 1]; // neighbours of object i are neighbours[start[i]] up to neighbours[start[i + 1]]
+    int16_t neighbours[MAX_CONTACT_NEIGHBOURS];
+    float min_x[MAX_PHYSICS_OBJECTS]; // grown boxes
+    float min_y[MAX_PHYSICS_OBJECTS];
+    float max_x[MAX_PHYSICS_OBJECTS];
+    float max_y[MAX_PHYSICS_OBJECTS];
+    bool listed[MAX_PHYSICS_OBJECTS]; // object was in the list when it was built and hasn't jumped since
+    int16_t late[MAX_PHYSICS_OBJECTS]; // spawned or teleported since the list was built, everyone checks these
+    int32_t late_count;
+} ContactList;
+
+// contacts_build sorts these instead of the object indices so the comparator doesnt need the list
+typedef struct ContactKey_t {
+    float min_x;
+    int16_t object;
+} ContactKey;
+
+// Refers to an entity in one of the GameState pools without pointing at it. The low 16 bits are the
+// slot and the high 16 are the generation the slot had when the handle was made, so a handle to
+// something that died (or whose slot got reused) resolves to null instead of the wrong entity. 0
+// is never a valid handle.
+typedef uint32_t EntityHandle;
+
+// What a character is touching, probed once at the start of its update and shared by input, ai
+// and physics for the rest of the frame
+typedef struct ContactState_t {
+    bool grounded; // anything solid within GROUND_PROBE_DISTANCE below
+    uint8_t ground_tile; // TileFlags of the ground, 0 if its standing on an entity or in the air
+    // who's one body width to either side, only probed for grounded ai dashers
+    EntityHandle left;
+    EntityHandle right;
+} ContactState;
 
 typedef struct Character_t {
     CharacterType type; // Type of opp
     uint64_t id;
     Oct_SpriteInstance sprite;
-    bool alive;
-    PhysicsObject physx;
+    PhysicsObject *physx; // this character's entry in GameState::physics
+    ContactState contact;
     float facing; // direction facing, -1 or 1
     float shown_facing; // for a cool visual effect
     int32_t mouth_open; // for laser animation
@@ -348,26 +685,38 @@ typedef struct Character_t {
 
 typedef struct Particle_t {
     bool sprite_based; // if true the sprite and frame is used
-    PhysicsObject physx;
     float lifetime; // in seconds
     float total_lifetime;
     uint64_t id;
-    _Atomic bool alive;
     Oct_Sprite sprite;
     Oct_SpriteInstance instance;
     Oct_Texture texture;
+    AssetID sprite_id; // what sprite and texture are, handles don't mean anything to another process
+    AssetID texture_id;
+    float x_scale; // stretches the texture sideways, 1 is its own width
 } Particle;
 
 typedef struct Projectile_t {
-    PhysicsObject physx;
+    PhysicsObject *physx; // this projectile's entry in GameState::physics
     float lifetime; // in seconds
     float max_lifetime;
     Oct_Texture tex;
+    AssetID tex_id;
     uint64_t id;
     bool player_bullet; // whether the player shot it
-    _Atomic bool alive;
 } Projectile;
 
+// Slot bookkeeping for the fixed entity arrays in GameState, one bit per slot and a set bit means
+// whatever is in that slot is alive. Slots are handed out lowest first and updated in slot order, the
+// same as the original scans over the arrays, so a new spawn in a freed low slot acts before older
+// entities further up (eg gets the first punch in between two dashers).
+typedef struct EntityPool_t {
+    uint64_t alive[POOL_WORDS];
+    uint16_t generation[MAX_POOL_SIZE]; // bumped every time a slot comes alive, never 0
+    int32_t capacity;
+    int32_t count; // slots alive
+} EntityPool;
+
 // Represents unified player and ai input
 typedef struct InputProfile_t {
     float x_acc;
@@ -375,20 +724,55 @@ typedef struct InputProfile_t {
     bool action;
 } InputProfile;
 
+// PCG32 state, see https://www.pcg-random.org
+typedef struct Rng_t {
+    uint64_t state;
+    uint64_t inc; // stream selector, always odd
+} Rng;
+
+// Everything the game reads from the keyboard/gamepad, sampled once per frame by poll_input
+typedef struct FrameInput_t {
+    uint16_t buttons; // InputButton bits
+    int8_t axis_x; // left stick, -127 to 127
+} FrameInput;
+
 // Types of things you can collide with
 typedef struct CollisionEvent_t {
     CollisionEventType type;
     union {
-        int32_t wallIndex;
-        Character *character;
-        Projectile *projectile;
+        uint8_t wall; // TileFlags of the wall
+        EntityHandle character;
+        EntityHandle projectile;
     };
 } CollisionEvent;
 
+// Result of moving a physics object along one axis
+typedef struct SweepResult_t {
+    CollisionEvent event; // first thing in the way, COLLISION_EVENT_TYPE_NO_COLLISION if the path is clear
+    float position; // x or y the object ends up at when touching it
+    float normal; // -1 or 1 along the swept axis, 0 if nothing was hit
+} SweepResult;
+
+// What a ray ran into, see raycast
+typedef struct RaycastResult_t {
+    float distance; // how far the ray got before a wall, the full length if it didn't hit one
+    uint8_t wall; // TileFlags of the wall it stopped at, 0 if nothing
+    int32_t count; // entities written to out along the way
+} RaycastResult;
+
+// Particle positions and velocities, kept out of Particle so the integrator runs over flat arrays
+typedef struct ParticleBodies_t {
+    float x[MAX_PARTICLES];
+    float y[MAX_PARTICLES];
+    float x_vel[MAX_PARTICLES];
+    float y_vel[MAX_PARTICLES];
+} ParticleBodies;
+
+// A range of particle slots for one job
 typedef struct ParticleJob_t {
-    int32_t index;
+    struct GameState_t *state;
+    int32_t start;
     int32_t count;
-    Particle *list;
 } ParticleJob;
 
 typedef struct CreateParticlesJob_t {
@@ -398,9 +782,10 @@ typedef struct CreateParticlesJob_t {
     float x_vel;
     float y_vel;
     float variation; // 0 is none
-    Oct_Texture tex;
-    Oct_Sprite spr;
+    AssetID tex;
+    AssetID spr; // used over tex if its not ASSET_NONE
     float lifetime; // seconds
+    float x_scale; // for tex, 0 is the same as 1
 } CreateParticlesJob;
 
 typedef struct MenuState_t {
@@ -423,15 +808,143 @@ typedef struct MenuState_t {
 
 MenuState menu_state;
 
+// Per phase frame timings, lives outside GameState so it survives going back to the menu
+typedef struct Profiler_t {
+    uint64_t history[PROFILE_HISTORY][PROFILE_PHASE_MAX]; // ring buffer of finished frames in ns
+    uint64_t current[PROFILE_PHASE_MAX]; // this frame so far
+    uint64_t started[PROFILE_PHASE_MAX]; // when each open phase began
+    int32_t head; // next row of history to write
+    int32_t count; // rows of history that are filled
+    bool overlay; // toggled with F3
+    FILE *csv; // every frame gets a row in here if its set
+} Profiler;
+
+thread_local Profiler gProfiler; // the overlay and csv are the main thread's, batch workers time into their own
+
+// A snapshot of the game taken between frames while recording so playback can jump there
+typedef struct ReplayKeyframe_t {
+    int32_t frame; // game_updates done when it was taken
+    uint32_t size;
+    uint8_t *data; // see snapshot_save
+} ReplayKeyframe;
+
+// xxh64 of each part of a frame's snapshot with the cosmetic fields left out, cut to 32 bits
+typedef struct StateHash_t {
+    uint32_t parts[STATE_HASH_MAX];
+} StateHash;
+
+// Everything needed to play a run back frame for frame. On disk it's a REPLAY_HEADER_SIZE byte header
+// (magic, u8 version, u8 flags, u8 map, u8 body, u64 seed, u32 frames, u32 runs, little endian) followed
+// by the input as run-length encoded FrameInputs (see replay_save), then a u32 keyframe count and each
+// keyframe as u32 frame, u32 size and the snapshot. With REPLAY_FLAG_HASHES that's followed by a u32
+// hash count and the StateHashes as u32s.
+typedef struct Replay_t {
+    ReplayMode mode;
+    const char *filename;
+    uint64_t seed;
+    StartingMap map;
+    StartingBody body;
+    bool tutorial; // whether the run started in the tutorial, it changes how the game plays
+    FrameInput *frames; // one per game_update
+    int32_t count;
+    int32_t capacity;
+    int32_t cursor; // next frame to play back
+    ReplayKeyframe *keyframes; // one every REPLAY_KEYFRAME_INTERVAL frames, in order
+    int32_t keyframe_count;
+    int32_t keyframe_capacity;
+    int32_t speed; // game_updates per drawn frame when playing back, 0 is the same as 1
+    int32_t start_frame; // where playback jumps to once the game starts
+    bool hashing; // keep a StateHash for every frame while recording
+    StateHash *hashes; // hashes[i] is from after i game_updates, checked while playing back
+    int32_t hash_count;
+    int32_t hash_capacity;
+    uint8_t *scratch; // SNAPSHOT_MAX_SIZE bytes to hash snapshots in
+    bool desynced; // a hash didn't match while playing back, checking stops at the first
+    int32_t desync_frame;
+    StateHashPart desync_part;
+} Replay;
+
+Replay gReplay; // the one from the command line
+
+// Summary of one phase over the profiler history, in milliseconds
+typedef struct ProfileStats_t {
+    double min;
+    double avg;
+    double p99;
+} ProfileStats;
+
+// One headless game for run_batch, either a fresh seed with nobody at the controls or a replay
+typedef struct BatchJob_t {
+    StartingMap map;
+    StartingBody body;
+    uint64_t seed;
+    char replay[260]; // replay file to take the input (and map, body and seed) from, empty for none
+} BatchJob;
+
+typedef struct BatchResult_t {
+    StartingMap map;
+    StartingBody body;
+    uint64_t seed;
+    int32_t frames;
+    float score;
+    float survived; // seconds, the whole run if the player never died
+    int32_t phase;
+    int32_t kills;
+    double fps;
+    int32_t desync_frame; // first frame a replay's hashes didn't match, -1 if they all did or it has none
+    StateHashPart desync_part;
+    bool failed; // the replay couldn't be loaded, nothing else is filled in
+} BatchResult;
+
+// A worker's share of the batch. The jobs left are [next, end) packed into one word so the owner
+// taking from the front and a thief taking from the back can never both get the last one.
+typedef struct BatchQueue_t {
+    _Alignas(64) _Atomic uint64_t range; // next in the low 32 bits, end in the high 32
+} BatchQueue;
+
+typedef struct Batch_t {
+    const BatchJob *jobs;
+    BatchResult *results; // one per job, in the same order
+    int32_t count;
+    int32_t frames; // most a run can go for
+    BatchQueue *queues; // one per worker
+    int32_t workers;
+} Batch;
+
+typedef struct BatchWorker_t {
+    Batch *batch;
+    int32_t index; // which queue is this worker's own
+} BatchWorker;
+
+// Walks the fields in a snapshot, copying them from the state into the buffer when saving and the
+// other way when restoring so both directions go off the same list (see snapshot_fields)
+typedef struct SnapshotCursor_t {
+    uint8_t *at;
+    const uint8_t *end;
+    bool saving;
+    bool overrun; // ran off the end, nothing after that got copied
+    bool hashing; // leave out anything cosmetic, see state_hash
+    uint8_t *parts[STATE_HASH_MAX]; // where each StateHashPart starts
+} SnapshotCursor;
+
+// What was in each slot, so sprite instances can be started for whatever turned up while nothing
+// was being drawn (restoring a snapshot or fast forwarding a replay), see sprite_slots_refresh
+typedef struct SpriteSlots_t {
+    uint64_t characters[MAX_CHARACTERS]; // id, 0 for a dead slot
+    CharacterType character_types[MAX_CHARACTERS];
+    uint64_t particles[MAX_PARTICLES];
+} SpriteSlots;
+
 // LEAVE THIS AT THE BOTTOM
 typedef struct GameState_t {
     // set when player gets a character
     float lifespan;
     float max_lifespan;
-    Character *player;
+    EntityHandle player;
     float total_time;
     int32_t req_kills; // for transforming
     int32_t current_kills;
+    int32_t kills; // everything the player killed this run
     int32_t req_kills_accumulator;
     float displayed_kills; // for lerping a nice val
     int32_t player_iframes; // after getting hit
@@ -441,6 +954,15 @@ typedef struct GameState_t {
     bool got_highscore;
     int32_t frame_count;
     int32_t game_phase;
+    uint64_t seed; // everything random in a run comes from this
+    Rng rng[RNG_STREAM_MAX];
+    StartingMap map;
+    StartingBody body;
+    Replay *replay; // where input comes from or gets recorded to, null if neither
+    uint64_t frame; // game_updates so far counting the one in progress, ai and spawn timers go off this
+    uint64_t next_id; // interpolation id for the next thing spawned
+    uint64_t sounds; // sounds that would have played in headless mode
+    uint64_t collision_tests; // tile and body overlap checks, reported by the benchmark
 
     bool in_tutorial;
     Oct_Sound outta_time;
@@ -451,50 +973,216 @@ typedef struct GameState_t {
     float fade_out;
     float player_transform_time;
 
-    Oct_Tilemap level_map;
+    Oct_Tilemap level_map; // only for drawing, collisions use collision
+    uint8_t collision[LEVEL_TILES]; // TileFlags of every tile, built in game_begin
+    FrameInput input;
+    GlobalSpacePartition partition;
+    ContactList contacts;
+    PhysicsObject physics[MAX_PHYSICS_OBJECTS]; // characters then projectiles, packed so broadphase scans don't walk whole entities
+    EntityPool character_pool;
+    EntityPool projectile_pool;
+    EntityPool particle_pool;
     Character characters[MAX_CHARACTERS];
     Projectile projectiles[MAX_PROJECTILES];
     Particle particles[MAX_PARTICLES];
+    ParticleBodies particle_bodies;
 } GameState;
 
-GameState state;
+GameState game_state; // the game in the window, or the one run_headless runs
 
-#define NEAR_LEVEL_UP (state.req_kills - 1 == state.current_kills)
+#define NEAR_LEVEL_UP(state) ((state)->req_kills - 1 == (state)->current_kills)
+#define SNAPSHOT_MAX_SIZE (SNAPSHOT_HEADER_SIZE + sizeof(struct GameState_t)) // way more than the fields in one could ever take
 
 ///////////////////////// HELPERS /////////////////////////
-Projectile *create_projectile(bool player_shot, Oct_Texture tex, float lifetime, float x, float y, float x_speed, float y_speed);
+Projectile *create_projectile(GameState *state, bool player_shot, AssetID tex, float lifetime, float x, float y, float x_speed, float y_speed);
 Save parse_save();
 void save_game(Save *save);
 
-void create_particles_job(CreateParticlesJob *data) {
+// the loaded asset for id, OCT_NO_ASSET for ASSET_NONE or anything headless
+static inline Oct_Asset asset_get(AssetID id) {
+    return id < ASSET_MAX ? gAssets[id] : OCT_NO_ASSET;
+}
+
+// oct_PlaySound that only counts the sound into state in headless mode, the menu passes null
+Oct_Sound play_sound(GameState *state, Oct_Asset sound, Oct_Vec2 volume, bool repeat) {
+    if (gHeadless) {
+        if (state) state->sounds++;
+        return UINT64_MAX;
+    }
+    return oct_PlaySound(sound, volume, repeat);
+}
+
+// TileFlags at a grid position, anything outside the level is empty
+static inline uint8_t level_tile(GameState *state, int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= LEVEL_WIDTH || y >= LEVEL_HEIGHT) return 0;
+    return state->collision[(y * LEVEL_WIDTH) + x];
+}
+
+// the flags walls need to have to stop this character, ai walk through the invisible ones
+static inline uint8_t wall_ignore_mask(Character *this_c) {
+    return this_c && !this_c->player_controlled ? TILE_FLAG_AI_INVISIBLE : 0;
+}
+
+uint32_t rng_next(Rng *rng) {
+    const uint64_t old = rng->state;
+    rng->state = (old * 6364136223846793005ULL) + rng->inc;
+    const uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+    const uint32_t rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+void rng_seed(Rng *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+// replaces oct_Random in gameplay code, min <= x < max
+float rng_float(GameState *state, RngStream stream, float min, float max) {
+    const float unit = (rng_next(&state->rng[stream]) >> 8) * (1.0f / 16777216.0f);
+    return min + (unit * (max - min));
+}
+
+void pool_init(EntityPool *pool, int32_t capacity) {
+    memset(pool, 0, sizeof(struct EntityPool_t));
+    pool->capacity = capacity;
+}
+
+static inline bool pool_alive(const EntityPool *pool, int32_t slot) {
+    return (pool->alive[slot / 64] >> (slot % 64)) & 1;
+}
+
+// 0 is reserved for "no handle" so the generation skips it when it wraps
+static inline void pool_bump_generation(EntityPool *pool, int32_t slot) {
+    if (++pool->generation[slot] == 0) pool->generation[slot] = 1;
+}
+
+// returns the lowest free slot or -1 if the pool is full
+int32_t pool_alloc(EntityPool *pool) {
+    for (int32_t word = 0; word < POOL_WORDS; word++) {
+        if (pool->alive[word] == UINT64_MAX) continue;
+        const int32_t slot = (word * 64) + __builtin_ctzll(~pool->alive[word]);
+        if (slot >= pool->capacity) return -1;
+        pool->alive[word] |= 1ULL << (slot % 64);
+        pool->count++;
+        pool_bump_generation(pool, slot);
+        return slot;
+    }
+    return -1;
+}
+
+// brings a specific slot back, for things that come back to life. its a new generation so handles
+// to whatever was in the slot before stay dead.
+void pool_reclaim(EntityPool *pool, int32_t slot) {
+    if (pool_alive(pool, slot)) return;
+    pool->alive[slot / 64] |= 1ULL << (slot % 64);
+    pool->count++;
+    pool_bump_generation(pool, slot);
+}
+
+void pool_free(EntityPool *pool, int32_t slot) {
+    if (!pool_alive(pool, slot)) return;
+    pool->alive[slot / 64] &= ~(1ULL << (slot % 64));
+    pool->count--;
+}
+
+// First live slot at or after slot, or -1. Iterate with
+//     for (int32_t i = pool_next(pool, 0); i != -1; i = pool_next(pool, i + 1))
+// the bits are read fresh every step so anything freed is skipped and anything allocated past i is
+// visited.
+static inline int32_t pool_next(const EntityPool *pool, int32_t slot) {
+    for (int32_t word = slot / 64; word < POOL_WORDS; word++) {
+        uint64_t bits = pool->alive[word];
+        if (word == slot / 64) bits &= UINT64_MAX << (slot % 64);
+        if (bits) return (word * 64) + __builtin_ctzll(bits);
+    }
+    return -1;
+}
+
+// one past the highest live slot
+int32_t pool_end(const EntityPool *pool) {
+    for (int32_t word = POOL_WORDS - 1; word >= 0; word--)
+        if (pool->alive[word]) return (word * 64) + 64 - __builtin_clzll(pool->alive[word]);
+    return 0;
+}
+
+// handle for whatever currently lives in slot
+static inline EntityHandle pool_handle(const EntityPool *pool, int32_t slot) {
+    return ((EntityHandle)pool->generation[slot] << 16) | (EntityHandle)slot;
+}
+
+// slot the handle refers to, or -1 if its 0, out of range, dead or from an older generation
+static inline int32_t pool_resolve(const EntityPool *pool, EntityHandle handle) {
+    const int32_t slot = handle & 0xFFFF;
+    if (handle == 0 || slot >= pool->capacity || !pool_alive(pool, slot)) return -1;
+    if (pool->generation[slot] != handle >> 16) return -1;
+    return slot;
+}
+
+static inline bool character_alive(GameState *state, const Character *character) {
+    return pool_alive(&state->character_pool, character - state->characters);
+}
+
+static inline bool projectile_alive(GameState *state, const Projectile *projectile) {
+    return pool_alive(&state->projectile_pool, projectile - state->projectiles);
+}
+
+static inline EntityHandle character_handle(GameState *state, const Character *character) {
+    return pool_handle(&state->character_pool, character - state->characters);
+}
+
+static inline EntityHandle projectile_handle(GameState *state, const Projectile *projectile) {
+    return pool_handle(&state->projectile_pool, projectile - state->projectiles);
+}
+
+// null if the character the handle was made for is gone
+static inline Character *character_get(GameState *state, EntityHandle handle) {
+    const int32_t slot = pool_resolve(&state->character_pool, handle);
+    return slot == -1 ? null : &state->characters[slot];
+}
+
+static inline Projectile *projectile_get(GameState *state, EntityHandle handle) {
+    const int32_t slot = pool_resolve(&state->projectile_pool, handle);
+    return slot == -1 ? null : &state->projectiles[slot];
+}
+
+// these hand dead entities back to their pools, calling them on something already dead does nothing
+void release_character(GameState *state, Character *character) {
+    pool_free(&state->character_pool, character - state->characters);
+}
+
+void release_projectile(GameState *state, Projectile *projectile) {
+    pool_free(&state->projectile_pool, projectile - state->projectiles);
+}
+
+void release_particle(GameState *state, Particle *particle) {
+    pool_free(&state->particle_pool, particle - state->particles);
+}
+
+void create_particles_job(GameState *state, CreateParticlesJob *data) {
     CreateParticlesJob *job = data;
     for (int i = 0; i < job->count; i++) {
-        // find a spot in the list for this particle
-        int32_t spot = -1;
-        for (int j = 0; j < MAX_PARTICLES; j++) {
-            if (!state.particles[j].alive) {
-                spot = j;
-                break;
-            }
-        }
+        // grab a spot in the list for this particle
+        const int32_t spot = pool_alloc(&state->particle_pool);
 
         if (spot >= 0) {
-            Particle *p = &state.particles[spot];
-            p->sprite_based = job->spr != OCT_NO_ASSET;
-            p->physx = (PhysicsObject){
-                    .x = job->x,
-                    .y = job->y,
-                    .x_vel = job->x_vel + oct_Random(-job->variation, job->variation),
-                    .y_vel = job->y_vel + oct_Random(-job->variation, job->variation),
-                    .noclip = true
-            };
+            Particle *p = &state->particles[spot];
+            p->sprite_based = job->spr != ASSET_NONE;
+            state->particle_bodies.x[spot] = job->x;
+            state->particle_bodies.y[spot] = job->y;
+            state->particle_bodies.x_vel[spot] = job->x_vel + rng_float(state, RNG_STREAM_COSMETIC, -job->variation, job->variation);
+            state->particle_bodies.y_vel[spot] = job->y_vel + rng_float(state, RNG_STREAM_COSMETIC, -job->variation, job->variation);
             p->lifetime = job->lifetime;
             p->total_lifetime = job->lifetime;
-            p->texture = job->tex;
-            if (p->sprite_based) p->sprite = job->spr;
-            oct_InitSpriteInstance(&p->instance, job->spr, true);
-            p->id = gParticleIDs++;
-            p->alive = true;
+            p->texture = asset_get(job->tex);
+            p->texture_id = job->tex;
+            p->sprite = asset_get(job->spr);
+            p->sprite_id = job->spr;
+            p->x_scale = job->x_scale > 0 ? job->x_scale : 1;
+            if (!gHeadless) oct_InitSpriteInstance(&p->instance, p->sprite, true);
+            p->id = state->next_id++;
         }
     }
 }
@@ -508,91 +1196,846 @@ static inline bool aabb(float x1, float y1, float w1, float h1, float x2, float
 }
 
 // returns the sprite corresponding to a certain character type
-Oct_Sprite character_type_sprite(Character *character) {
+AssetID character_type_sprite_id(Character *character) {
     if (character->player_controlled) {
         switch (character->type) {
-            case CHARACTER_TYPE_JUMPER: return oct_GetAsset(gBundle, "sprites/playerjumper.json");
-            case CHARACTER_TYPE_X_SHOOTER: return oct_GetAsset(gBundle, "sprites/playershooter.json");
-            case CHARACTER_TYPE_Y_SHOOTER: return oct_GetAsset(gBundle, "sprites/playershooter.json");
-            case CHARACTER_TYPE_XY_SHOOTER: return oct_GetAsset(gBundle, "sprites/playershooter.json");
-            case CHARACTER_TYPE_BOMBER: return oct_GetAsset(gBundle, "sprites/playerbomber.json");
-            case CHARACTER_TYPE_LASER: return oct_GetAsset(gBundle, "sprites/playerlaser.json");
-            case CHARACTER_TYPE_DASHER: return oct_GetAsset(gBundle, "sprites/playerdasher.json");
-            default: return OCT_NO_ASSET;
+            case CHARACTER_TYPE_JUMPER: return ASSET_SPR_PLAYERJUMPER;
+            case CHARACTER_TYPE_X_SHOOTER: return ASSET_SPR_PLAYERSHOOTER;
+            case CHARACTER_TYPE_Y_SHOOTER: return ASSET_SPR_PLAYERSHOOTER;
+            case CHARACTER_TYPE_XY_SHOOTER: return ASSET_SPR_PLAYERSHOOTER;
+            case CHARACTER_TYPE_BOMBER: return ASSET_SPR_PLAYERBOMBER;
+            case CHARACTER_TYPE_LASER: return ASSET_SPR_PLAYERLASER;
+            case CHARACTER_TYPE_DASHER: return ASSET_SPR_PLAYERDASHER;
+            default: return ASSET_NONE;
         }
     }
 
     switch (character->type) {
-        case CHARACTER_TYPE_JUMPER: return oct_GetAsset(gBundle, "sprites/jumper.json");
-        case CHARACTER_TYPE_X_SHOOTER: return oct_GetAsset(gBundle, "sprites/shooter.json");
-        case CHARACTER_TYPE_Y_SHOOTER: return oct_GetAsset(gBundle, "sprites/shooter.json");
-        case CHARACTER_TYPE_XY_SHOOTER: return oct_GetAsset(gBundle, "sprites/shooter.json");
-        case CHARACTER_TYPE_BOMBER: return oct_GetAsset(gBundle, "sprites/bomber.json");
-        case CHARACTER_TYPE_LASER: return oct_GetAsset(gBundle, "sprites/laser.json");
-        case CHARACTER_TYPE_DASHER: return oct_GetAsset(gBundle, "sprites/dasher.json");
-        default: return OCT_NO_ASSET;
+        case CHARACTER_TYPE_JUMPER: return ASSET_SPR_JUMPER;
+        case CHARACTER_TYPE_X_SHOOTER: return ASSET_SPR_SHOOTER;
+        case CHARACTER_TYPE_Y_SHOOTER: return ASSET_SPR_SHOOTER;
+        case CHARACTER_TYPE_XY_SHOOTER: return ASSET_SPR_SHOOTER;
+        case CHARACTER_TYPE_BOMBER: return ASSET_SPR_BOMBER;
+        case CHARACTER_TYPE_LASER: return ASSET_SPR_LASER;
+        case CHARACTER_TYPE_DASHER: return ASSET_SPR_DASHER;
+        default: return ASSET_NONE;
+    }
+}
+
+Oct_Sprite character_type_sprite(Character *character) {
+    return asset_get(character_type_sprite_id(character));
+}
+
+///////////////////////// REPLAY /////////////////////////
+static void put_u16(uint8_t *dst, uint16_t v) {
+    dst[0] = v & 0xff;
+    dst[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *dst, uint32_t v) {
+    put_u16(dst, v & 0xffff);
+    put_u16(dst + 2, v >> 16);
+}
+
+static void put_u64(uint8_t *dst, uint64_t v) {
+    put_u32(dst, v & 0xffffffff);
+    put_u32(dst + 4, v >> 32);
+}
+
+static uint16_t get_u16(const uint8_t *src) {
+    return src[0] | (src[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *src) {
+    return get_u16(src) | ((uint32_t)get_u16(src + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *src) {
+    return get_u32(src) | ((uint64_t)get_u32(src + 4) << 32);
+}
+
+uint32_t snapshot_save(GameState *state, uint8_t *out, uint32_t capacity);
+void state_hash(GameState *state, uint8_t *scratch, StateHash *out);
+
+// throws out the keyframes taken at or after frame
+static void replay_drop_keyframes(Replay *replay, int32_t frame) {
+    while (replay->keyframe_count > 0 && replay->keyframes[replay->keyframe_count - 1].frame >= frame)
+        oct_Free(gAllocator, replay->keyframes[--replay->keyframe_count].data);
+}
+
+// called from game_begin, a new game throws out whatever was recorded before
+void replay_start_recording(GameState *state) {
+    state->replay->seed = state->seed;
+    state->replay->map = state->map;
+    state->replay->body = state->body;
+    state->replay->tutorial = state->in_tutorial;
+    state->replay->count = 0;
+    state->replay->hash_count = 0;
+    replay_drop_keyframes(state->replay, 0);
+}
+
+static ReplayKeyframe *replay_new_keyframe(Replay *replay) {
+    if (replay->keyframe_count == replay->keyframe_capacity) {
+        replay->keyframe_capacity = replay->keyframe_capacity ? replay->keyframe_capacity * 2 : 16;
+        replay->keyframes = oct_Realloc(gAllocator, replay->keyframes, replay->keyframe_capacity * sizeof(ReplayKeyframe));
+    }
+    return &replay->keyframes[replay->keyframe_count++];
+}
+
+// called at the start of game_update while recording, before the frame's input is taken
+void replay_add_keyframe(GameState *state) {
+    uint8_t *data = oct_Malloc(gAllocator, SNAPSHOT_MAX_SIZE);
+    const uint32_t size = snapshot_save(state, data, SNAPSHOT_MAX_SIZE);
+    *replay_new_keyframe(state->replay) = (ReplayKeyframe){
+            .frame = state->frame,
+            .size = size,
+            .data = oct_Realloc(gAllocator, data, size),
+    };
+}
+
+static StateHash *replay_new_hash(Replay *replay) {
+    if (replay->hash_count == replay->hash_capacity) {
+        replay->hash_capacity = replay->hash_capacity ? replay->hash_capacity * 2 : 30 * 60;
+        replay->hashes = oct_Realloc(gAllocator, replay->hashes, replay->hash_capacity * sizeof(StateHash));
+    }
+    return &replay->hashes[replay->hash_count++];
+}
+
+static uint8_t *replay_scratch(Replay *replay) {
+    if (!replay->scratch)
+        replay->scratch = oct_Malloc(gAllocator, SNAPSHOT_MAX_SIZE);
+    return replay->scratch;
+}
+
+// Called between frames (state->frame game_updates in) from game_update and game_end. Recording keeps
+// a keyframe every REPLAY_KEYFRAME_INTERVAL frames and a hash every frame if its hashing, playing back
+// checks the hashes the replay came with and reports the first one that doesn't match.
+void replay_between_frames(GameState *state) {
+    Replay *replay = state->replay;
+    const int32_t frame = state->frame;
+    if (replay->mode == REPLAY_MODE_RECORDING) {
+        const int32_t last_keyframe = replay->keyframe_count > 0 ? replay->keyframes[replay->keyframe_count - 1].frame : -1;
+        if (frame % REPLAY_KEYFRAME_INTERVAL == 0 && frame > last_keyframe)
+            replay_add_keyframe(state);
+        if (replay->hashing && replay->hash_count == frame)
+            state_hash(state, replay_scratch(replay), replay_new_hash(replay));
+    } else if (replay->mode == REPLAY_MODE_PLAYING && !replay->desynced && frame < replay->hash_count) {
+        StateHash hash;
+        state_hash(state, replay_scratch(replay), &hash);
+        for (int i = 0; i < STATE_HASH_MAX && !replay->desynced; i++) {
+            if (hash.parts[i] != replay->hashes[frame].parts[i]) {
+                replay->desynced = true;
+                replay->desync_frame = frame;
+                replay->desync_part = i;
+                oct_Raise(OCT_STATUS_ERROR, false, "replay %s desynced at frame %i in the %s", replay->filename, frame, STATE_HASH_PART_NAMES[i]);
+            }
+        }
+    }
+}
+
+// Moves the replay to frame (game_updates in), playing back carries on from there and recording
+// forgets everything that came after it
+void replay_rewind(Replay *replay, int32_t frame) {
+    if (replay->mode == REPLAY_MODE_PLAYING) {
+        replay->cursor = frame < replay->count ? frame : replay->count;
+    } else if (replay->mode == REPLAY_MODE_RECORDING) {
+        if (frame < replay->count) replay->count = frame;
+        if (frame < replay->hash_count) replay->hash_count = frame;
+        replay_drop_keyframes(replay, frame);
+    }
+}
+
+void replay_free(Replay *replay) {
+    replay_drop_keyframes(replay, 0);
+    if (replay->keyframes) oct_Free(gAllocator, replay->keyframes);
+    if (replay->frames) oct_Free(gAllocator, replay->frames);
+    if (replay->hashes) oct_Free(gAllocator, replay->hashes);
+    if (replay->scratch) oct_Free(gAllocator, replay->scratch);
+    replay->keyframes = null;
+    replay->keyframe_capacity = 0;
+    replay->frames = null;
+    replay->count = 0;
+    replay->capacity = 0;
+    replay->hashes = null;
+    replay->hash_count = 0;
+    replay->hash_capacity = 0;
+    replay->scratch = null;
+}
+
+void replay_push(Replay *replay, FrameInput input) {
+    if (replay->count == replay->capacity) {
+        replay->capacity = replay->capacity ? replay->capacity * 2 : 30 * 60;
+        replay->frames = oct_Realloc(gAllocator, replay->frames, replay->capacity * sizeof(FrameInput));
     }
+    replay->frames[replay->count++] = input;
+}
+
+bool replay_finished(const Replay *replay) {
+    return replay->mode == REPLAY_MODE_PLAYING && replay->cursor >= replay->count;
+}
+
+void replay_save(const Replay *replay) {
+    uint32_t keyframe_size = 4;
+    for (int i = 0; i < replay->keyframe_count; i++)
+        keyframe_size += 8 + replay->keyframes[i].size;
+    const uint32_t hash_size = replay->hash_count > 0 ? 4 + (replay->hash_count * STATE_HASH_MAX * 4) : 0;
+
+    // runs of identical input, worst case every frame is different
+    uint8_t *data = oct_Malloc(gAllocator, REPLAY_HEADER_SIZE + (replay->count * REPLAY_RUN_SIZE) + keyframe_size + hash_size);
+    uint8_t *run = data + REPLAY_HEADER_SIZE;
+    uint32_t runs = 0;
+    for (int i = 0; i < replay->count;) {
+        const FrameInput input = replay->frames[i];
+        int32_t length = 1;
+        while (i + length < replay->count && length < UINT16_MAX &&
+               replay->frames[i + length].buttons == input.buttons &&
+               replay->frames[i + length].axis_x == input.axis_x)
+            length++;
+        put_u16(run, length);
+        put_u16(run + 2, input.buttons);
+        run[4] = (uint8_t)input.axis_x;
+        run += REPLAY_RUN_SIZE;
+        runs++;
+        i += length;
+    }
+
+    uint8_t *end = run;
+    put_u32(end, replay->keyframe_count);
+    end += 4;
+    for (int i = 0; i < replay->keyframe_count; i++) {
+        const ReplayKeyframe *keyframe = &replay->keyframes[i];
+        put_u32(end, keyframe->frame);
+        put_u32(end + 4, keyframe->size);
+        memcpy(end + 8, keyframe->data, keyframe->size);
+        end += 8 + keyframe->size;
+    }
+    if (replay->hash_count > 0) {
+        put_u32(end, replay->hash_count);
+        end += 4;
+        for (int i = 0; i < replay->hash_count; i++) {
+            for (int part = 0; part < STATE_HASH_MAX; part++, end += 4)
+                put_u32(end, replay->hashes[i].parts[part]);
+        }
+    }
+
+    memcpy(data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    data[4] = REPLAY_VERSION;
+    data[5] = (replay->tutorial ? REPLAY_FLAG_TUTORIAL : 0) | (replay->hash_count > 0 ? REPLAY_FLAG_HASHES : 0);
+    data[6] = replay->map;
+    data[7] = replay->body;
+    put_u64(data + 8, replay->seed);
+    put_u32(data + 16, replay->count);
+    put_u32(data + 20, runs);
+    oct_WriteFile(replay->filename, data, end - data);
+    oct_Free(gAllocator, data);
+}
+
+// Reads a replay file's contents into replay, returns what's wrong with it or null if nothing
+static const char *replay_parse(Replay *replay, const uint8_t *data, uint32_t size) {
+    if (size < REPLAY_HEADER_SIZE || memcmp(data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || data[4] < 1 || data[4] > REPLAY_VERSION)
+        return "isn't a replay this version can read";
+
+    replay->tutorial = data[5] & REPLAY_FLAG_TUTORIAL;
+    replay->map = data[6] % STARTING_MAP_MAX;
+    replay->body = data[7] % STARTING_BODY_MAX;
+    replay->seed = get_u64(data + 8);
+    const uint32_t frames = get_u32(data + 16);
+    const uint32_t runs = get_u32(data + 20);
+    if (size < REPLAY_HEADER_SIZE + ((uint64_t)runs * REPLAY_RUN_SIZE))
+        return "is cut off";
+
+    replay->count = 0;
+    replay->cursor = 0;
+    const uint8_t *run = data + REPLAY_HEADER_SIZE;
+    for (uint32_t i = 0; i < runs; i++, run += REPLAY_RUN_SIZE) {
+        const FrameInput input = {.buttons = get_u16(run + 2), .axis_x = (int8_t)run[4]};
+        for (int j = 0; j < get_u16(run); j++)
+            replay_push(replay, input);
+    }
+    if ((uint32_t)replay->count != frames)
+        return "has a different number of frames than its header says";
+
+    // keyframes are only checked for fitting in the file here, snapshot_restore turns down bad ones
+    replay_drop_keyframes(replay, 0);
+    const uint8_t *end = data + size;
+    const uint8_t *keyframe = run + 4;
+    const uint32_t keyframes = data[4] >= 2 && keyframe <= end ? get_u32(run) : 0;
+    for (uint32_t i = 0; i < keyframes; i++) {
+        if (end - keyframe < 8 || get_u32(keyframe + 4) > (uint64_t)(end - keyframe - 8))
+            return "is cut off";
+        const int32_t frame = get_u32(keyframe);
+        const uint32_t keyframe_size = get_u32(keyframe + 4);
+        if (frame <= (replay->keyframe_count ? replay->keyframes[replay->keyframe_count - 1].frame : -1) || frame > replay->count)
+            return "has a keyframe out of order";
+        ReplayKeyframe *dest = replay_new_keyframe(replay);
+        *dest = (ReplayKeyframe){
+                .frame = frame,
+                .size = keyframe_size,
+                .data = oct_Malloc(gAllocator, keyframe_size > 0 ? keyframe_size : 1),
+        };
+        memcpy(dest->data, keyframe + 8, keyframe_size);
+        keyframe += 8 + keyframe_size;
+    }
+
+    replay->hash_count = 0;
+    replay->desynced = false;
+    if (data[5] & REPLAY_FLAG_HASHES) {
+        const uint8_t *hash = keyframe + 4;
+        const uint32_t hashes = hash <= end ? get_u32(keyframe) : 0;
+        if (hash > end || (uint64_t)(end - hash) < (uint64_t)hashes * STATE_HASH_MAX * 4)
+            return "is cut off";
+        for (uint32_t i = 0; i < hashes; i++) {
+            StateHash *dest = replay_new_hash(replay);
+            for (int part = 0; part < STATE_HASH_MAX; part++, hash += 4)
+                dest->parts[part] = get_u32(hash);
+        }
+    }
+    return null;
+}
+
+// Loads replay->filename into replay, a missing or broken file is raised as fatal or not and returns
+// false. The batch runner can't have one bad job take every other one down with it.
+bool replay_load(Replay *replay, bool fatal) {
+    uint32_t size;
+    uint8_t *data = oct_ReadFile(replay->filename, gAllocator, &size);
+    if (!data) {
+        oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, fatal, "no replay %s", replay->filename);
+        return false;
+    }
+    const char *error = replay_parse(replay, data, size);
+    oct_Free(gAllocator, data);
+    if (error)
+        oct_Raise(OCT_STATUS_ERROR, fatal, "replay %s %s", replay->filename, error);
+    return error == null;
+}
+
+///////////////////////// SPACE PARTITION /////////////////////////
+// physics object index of a character or projectile in the partition
+static inline int32_t partition_object(GameState *state, Character *character, Projectile *projectile) {
+    if (character) return character - state->characters;
+    return MAX_CHARACTERS + (projectile - state->projectiles);
+}
+
+static inline PhysicsObject *partition_physx(GameState *state, int32_t object) {
+    return &state->physics[object];
+}
+
+static inline bool partition_alive(GameState *state, int32_t object) {
+    if (object < MAX_CHARACTERS) return pool_alive(&state->character_pool, object);
+    return pool_alive(&state->projectile_pool, object - MAX_CHARACTERS);
+}
+
+// grid coordinates are clamped so things above/beside the level still land in a cell
+static inline int32_t partition_column(float x) {
+    const int32_t column = floorf(x / PARTITION_CELL_SIZE);
+    return column < 0 ? 0 : (column >= PARTITION_COLUMNS ? PARTITION_COLUMNS - 1 : column);
+}
+
+static inline int32_t partition_row(float y) {
+    const int32_t row = floorf(y / PARTITION_CELL_SIZE);
+    return row < 0 ? 0 : (row >= PARTITION_ROWS ? PARTITION_ROWS - 1 : row);
+}
+
+void partition_clear(GameState *state) {
+    for (int i = 0; i < PARTITION_COLUMNS * PARTITION_ROWS; i++)
+        state->partition.partitions[i].head = -1;
+    for (int i = 0; i < MAX_PHYSICS_OBJECTS; i++) {
+        state->partition.next[i] = -1;
+        state->partition.prev[i] = -1;
+        state->partition.cell[i] = -1;
+    }
+}
+
+// moves an object into the cell it belongs in now, call whenever a character/projectile moves
+void partition_update(GameState *state, int32_t object) {
+    GlobalSpacePartition *partition = &state->partition;
+    const PhysicsObject *physx = partition_physx(state, object);
+    const int32_t cell = (partition_row(physx->y) * PARTITION_COLUMNS) + partition_column(physx->x);
+    if (cell == partition->cell[object]) return;
+
+    // unlink from old cell
+    if (partition->cell[object] != -1) {
+        if (partition->prev[object] != -1)
+            partition->next[partition->prev[object]] = partition->next[object];
+        else
+            partition->partitions[partition->cell[object]].head = partition->next[object];
+        if (partition->next[object] != -1)
+            partition->prev[partition->next[object]] = partition->prev[object];
+    }
+
+    // link into new one
+    partition->prev[object] = -1;
+    partition->next[object] = partition->partitions[cell].head;
+    if (partition->partitions[cell].head != -1)
+        partition->prev[partition->partitions[cell].head] = object;
+    partition->partitions[cell].head = object;
+    partition->cell[object] = cell;
+}
+
+// writes every object that might overlap the given area into out (MAX_PHYSICS_OBJECTS big), returns
+// how many. Since objects are filed by their top-left corner the search starts a cell up and left.
+int32_t partition_query(GameState *state, float x, float y, float width, float height, bool characters_only, int16_t *out) {
+    const int32_t column1 = partition_column(x - PARTITION_CELL_SIZE);
+    const int32_t row1 = partition_row(y - PARTITION_CELL_SIZE);
+    const int32_t column2 = partition_column(x + width);
+    const int32_t row2 = partition_row(y + height);
+    int32_t count = 0;
+
+    for (int32_t row = row1; row <= row2; row++) {
+        for (int32_t column = column1; column <= column2; column++) {
+            int32_t object = state->partition.partitions[(row * PARTITION_COLUMNS) + column].head;
+            while (object != -1) {
+                if (!characters_only || object < MAX_CHARACTERS)
+                    out[count++] = object;
+                object = state->partition.next[object];
+            }
+        }
+    }
+
+    return count;
+}
+
+// sort and sweep order for contacts_build, ties go to the lower object so its deterministic
+static inline bool contact_before(const ContactList *contacts, int16_t x, int16_t y) {
+    if (contacts->min_x[x] != contacts->min_x[y])
+        return contacts->min_x[x] < contacts->min_x[y];
+    return x < y;
+}
+
+// same order as contact_before
+static int compare_contact_keys(const void *a, const void *b) {
+    const ContactKey *x = a;
+    const ContactKey *y = b;
+    if (x->min_x != y->min_x)
+        return x->min_x < y->min_x ? -1 : 1;
+    return x->object - y->object;
+}
+
+// sorts objects by contact_before
+static void contacts_sort(const ContactList *contacts, int16_t *objects, int32_t count) {
+    ContactKey keys[MAX_PHYSICS_OBJECTS];
+    for (int32_t i = 0; i < count; i++)
+        keys[i] = (ContactKey){contacts->min_x[objects[i]], objects[i]};
+    qsort(keys, count, sizeof(ContactKey), compare_contact_keys);
+    for (int32_t i = 0; i < count; i++)
+        objects[i] = keys[i].object;
+}
+
+// Sweeps two lists sorted by contacts_sort (or one list against itself) and counts or writes
+// every pair whose boxes overlap. Each pair is found from whichever of the two comes first.
+static void contacts_sweep(GameState *state, const int16_t *a, int32_t a_count, const int16_t *b, int32_t b_count, int32_t *degree, bool fill) {
+    ContactList *contacts = &state->contacts;
+    const bool same = a == b;
+    for (int pass = 0; pass < (same ? 1 : 2); pass++) {
+        const int16_t *from = pass == 0 ? a : b;
+        const int16_t *to = pass == 0 ? b : a;
+        const int32_t from_count = pass == 0 ? a_count : b_count;
+        const int32_t to_count = pass == 0 ? b_count : a_count;
+
+        int32_t first = 0; // first of to thats sorted after from[i]
+        for (int32_t i = 0; i < from_count; i++) {
+            const int16_t x = from[i];
+            if (same) first = i + 1;
+            while (!same && first < to_count && contact_before(contacts, to[first], x)) first++;
+
+            for (int32_t j = first; j < to_count && contacts->min_x[to[j]] <= contacts->max_x[x]; j++) {
+                const int16_t y = to[j];
+                if (!fill) COUNT_COLLISION_TESTS(state, 1);
+                if (contacts->min_y[y] > contacts->max_y[x] || contacts->min_y[x] > contacts->max_y[y]) continue;
+                if (fill) {
+                    contacts->neighbours[contacts->start[x] + degree[x]++] = y;
+                    contacts->neighbours[contacts->start[y] + degree[y]++] = x;
+                } else {
+                    degree[x]++;
+                    degree[y]++;
+                }
+            }
+        }
+    }
+}
+
+// Rebuilds the contact list from every live character and projectile, call before anything moves.
+// Projectiles only pair with characters so they're sorted and swept separately.
+void contacts_build(GameState *state) {
+    ContactList *contacts = &state->contacts;
+    int16_t characters[MAX_CHARACTERS];
+    int16_t projectiles[MAX_PROJECTILES];
+    int32_t character_count = 0;
+    int32_t projectile_count = 0;
+    memset(contacts->listed, 0, sizeof(contacts->listed));
+    contacts->late_count = 0;
+
+    const EntityPool *pools[2] = {&state->character_pool, &state->projectile_pool};
+    for (int p = 0; p < 2; p++) {
+        for (int32_t i = pool_next(pools[p], 0); i != -1; i = pool_next(pools[p], i + 1)) {
+            const int32_t object = p == 0 ? i : MAX_CHARACTERS + i;
+            const PhysicsObject *physx = partition_physx(state, object);
+            contacts->min_x[object] = physx->x - CONTACT_MARGIN;
+            contacts->min_y[object] = physx->y - CONTACT_MARGIN;
+            contacts->max_x[object] = physx->x + physx->bb_width + CONTACT_MARGIN;
+            contacts->max_y[object] = physx->y + physx->bb_height + CONTACT_MARGIN;
+            contacts->listed[object] = true;
+            if (p == 0)
+                characters[character_count++] = object;
+            else
+                projectiles[projectile_count++] = object;
+        }
+    }
+    contacts_sort(contacts, characters, character_count);
+    contacts_sort(contacts, projectiles, projectile_count);
+
+    // count everyone's neighbours, work out where they go and then write them
+    int32_t degree[MAX_PHYSICS_OBJECTS] = {0};
+    contacts_sweep(state, characters, character_count, characters, character_count, degree, false);
+    contacts_sweep(state, characters, character_count, projectiles, projectile_count, degree, false);
+    contacts->start[0] = 0;
+    for (int32_t object = 0; object < MAX_PHYSICS_OBJECTS; object++) {
+        contacts->start[object + 1] = contacts->start[object] + degree[object];
+        degree[object] = 0;
+    }
+    contacts_sweep(state, characters, character_count, characters, character_count, degree, true);
+    contacts_sweep(state, characters, character_count, projectiles, projectile_count, degree, true);
+}
+
+// call when an object is spawned or teleported after contacts_build
+void contacts_late(GameState *state, int32_t object) {
+    ContactList *contacts = &state->contacts;
+    contacts->listed[object] = false;
+    if (contacts->late_count < MAX_PHYSICS_OBJECTS)
+        contacts->late[contacts->late_count++] = object;
+}
+
+// Everything self might overlap in the area. When self is in the contact list and the area is inside
+// its grown box thats just its neighbours and anything late, otherwise it comes from the grid. Either
+// way out (MAX_PHYSICS_OBJECTS big) is only candidates, they still need an overlap test.
+int32_t contact_candidates(GameState *state, int32_t self, float x, float y, float width, float height, bool characters_only, int16_t *out) {
+    const ContactList *contacts = &state->contacts;
+    const bool usable = self != -1 && contacts->listed[self] &&
+            (self < MAX_CHARACTERS || characters_only) && // projectile neighbours are only characters
+            x >= contacts->min_x[self] && y >= contacts->min_y[self] &&
+            x + width <= contacts->max_x[self] && y + height <= contacts->max_y[self];
+    if (!usable)
+        return partition_query(state, x, y, width, height, characters_only, out);
+
+    // something teleported can be in both lists, a duplicate candidate doesn't change any results
+    int32_t count = 0;
+    for (int32_t i = contacts->start[self]; i < contacts->start[self + 1]; i++) {
+        const int16_t object = contacts->neighbours[i];
+        if (!characters_only || object < MAX_CHARACTERS)
+            out[count++] = object;
+    }
+    for (int32_t i = 0; i < contacts->late_count && count < MAX_PHYSICS_OBJECTS; i++) {
+        const int16_t object = contacts->late[i];
+        if (!characters_only || object < MAX_CHARACTERS)
+            out[count++] = object;
+    }
+    return count;
+}
+
+// returns the lowest numbered live object overlapping the area, which is the same one a linear scan
+// of characters then projectiles would find first, or -1
+int32_t partition_first_hit(GameState *state, Character *this_c, Projectile *this_p, float x, float y, float width, float height, bool characters_only) {
+    int16_t candidates[MAX_PHYSICS_OBJECTS];
+    const int32_t self = this_c || this_p ? partition_object(state, this_c, this_p) : -1;
+    const int32_t count = contact_candidates(state, self, x, y, width, height, characters_only, candidates);
+    int32_t hit = -1;
+
+    for (int i = 0; i < count; i++) {
+        const int32_t object = candidates[i];
+        if (object == self || (hit != -1 && object > hit) || !partition_alive(state, object)) continue;
+        COUNT_COLLISION_TESTS(state, 1);
+        const PhysicsObject *physx = partition_physx(state, object);
+        if (aabb(x, y, width, height, physx->x, physx->y, physx->bb_width, physx->bb_height))
+            hit = object;
+    }
+
+    return hit;
+}
+
+// every live object overlapping the area in ascending order, so its the same order repeated
+// partition_first_hit calls would find them in. out needs room for MAX_PHYSICS_OBJECTS.
+int32_t partition_all_hits(GameState *state, Character *this_c, Projectile *this_p, float x, float y, float width, float height, bool characters_only, int16_t *out) {
+    int16_t candidates[MAX_PHYSICS_OBJECTS];
+    bool hit[MAX_PHYSICS_OBJECTS] = {0};
+    const int32_t self = this_c || this_p ? partition_object(state, this_c, this_p) : -1;
+    const int32_t count = contact_candidates(state, self, x, y, width, height, characters_only, candidates);
+    int32_t lowest = MAX_PHYSICS_OBJECTS;
+    int32_t highest = -1;
+
+    for (int i = 0; i < count; i++) {
+        const int32_t object = candidates[i];
+        if (object == self || !partition_alive(state, object)) continue;
+        COUNT_COLLISION_TESTS(state, 1);
+        const PhysicsObject *physx = partition_physx(state, object);
+        if (aabb(x, y, width, height, physx->x, physx->y, physx->bb_width, physx->bb_height)) {
+            hit[object] = true;
+            lowest = object < lowest ? object : lowest;
+            highest = object > highest ? object : highest;
+        }
+    }
+
+    int32_t hits = 0;
+    for (int32_t object = lowest; object <= highest; object++)
+        if (hit[object])
+            out[hits++] = object;
+    return hits;
 }
 
 // checks for collisions against the tilemap
 // returns < 0 means this is a collision with a projectile
-CollisionEvent collision_at(Character *this_c, Projectile *this_p, float x, float y, float width, float height) {
+CollisionEvent collision_at(GameState *state, Character *this_c, Projectile *this_p, float x, float y, float width, float height) {
     CollisionEvent e = {.type = COLLISION_EVENT_TYPE_NO_COLLISION};
-    int32_t grid_x1 = floorf(x / oct_TilemapCellWidth(state.level_map));
-    int32_t grid_y1 = floorf(y / oct_TilemapCellHeight(state.level_map));
-    int32_t grid_x2 = floorf((x + width) / oct_TilemapCellWidth(state.level_map));
-    int32_t grid_y2 = floorf((y + height) / oct_TilemapCellHeight(state.level_map));
-
-    int32_t wall[4] = {oct_GetTilemap(state.level_map, grid_x1, grid_y1),
-                       oct_GetTilemap(state.level_map, grid_x2, grid_y1),
-                       oct_GetTilemap(state.level_map, grid_x1, grid_y2),
-                       oct_GetTilemap(state.level_map, grid_x2, grid_y2)};
-    // 21
+    int32_t grid_x1 = floorf(x / TILE_SIZE);
+    int32_t grid_y1 = floorf(y / TILE_SIZE);
+    int32_t grid_x2 = floorf((x + width) / TILE_SIZE);
+    int32_t grid_y2 = floorf((y + height) / TILE_SIZE);
+
+    const uint8_t wall[4] = {level_tile(state, grid_x1, grid_y1),
+                             level_tile(state, grid_x2, grid_y1),
+                             level_tile(state, grid_x1, grid_y2),
+                             level_tile(state, grid_x2, grid_y2)};
+    const uint8_t ignore = wall_ignore_mask(this_c);
+    COUNT_COLLISION_TESTS(state, 4);
     for (int i = 0; i < 4; i++) {
-        // invisible walls for the player
-        if ((this_c && !this_c->player_controlled && wall[i] == 21)) continue;
-
-        if (wall[i]) {
-            e.type = wall[i] >= 2 && wall[i] <= 8 ? COLLISION_EVENT_TYPE_BOUNCY_WALL : COLLISION_EVENT_TYPE_WALL;
-            e.wallIndex = wall[i];
+        if ((wall[i] & TILE_FLAG_SOLID) && !(wall[i] & ignore)) {
+            e.type = wall[i] & TILE_FLAG_BOUNCY ? COLLISION_EVENT_TYPE_BOUNCY_WALL : COLLISION_EVENT_TYPE_WALL;
+            e.wall = wall[i];
             return e;
         }
     }
 
-    // If no wall collision we will check against all possible physics objects
-    // TODO: THIS MIGHT BE A PERFORMANCE PROBLEM LMAO
-    for (int i = 0; i < MAX_CHARACTERS; i++) {
-        if (&state.characters[i] == this_c || !state.characters[i].alive) continue;
-        if (aabb(x, y, width, height, state.characters[i].physx.x, state.characters[i].physx.y, state.characters[i].physx.bb_width, state.characters[i].physx.bb_height)) {
-            e.type = COLLISION_EVENT_TYPE_CHARACTER;
-            e.character = &state.characters[i];
-            return e;
+    // If no wall collision we will check against nearby physics objects
+    const int32_t hit = partition_first_hit(state, this_c, this_p, x, y, width, height, false);
+    if (hit != -1 && hit < MAX_CHARACTERS) {
+        e.type = COLLISION_EVENT_TYPE_CHARACTER;
+        e.character = character_handle(state, &state->characters[hit]);
+    } else if (hit != -1) {
+        e.type = COLLISION_EVENT_TYPE_PROJECTILE;
+        e.projectile = projectile_handle(state, &state->projectiles[hit - MAX_CHARACTERS]);
+    }
+
+    return e;
+}
+
+// Every character (and projectile unless characters_only) overlapping the area in one pass, walls
+// dont count. out needs room for MAX_PHYSICS_OBJECTS, returns how many were written.
+int32_t collision_region(GameState *state, Character *this_c, Projectile *this_p, float x, float y, float width, float height, bool characters_only, CollisionEvent *out) {
+    int16_t hits[MAX_PHYSICS_OBJECTS];
+    const int32_t count = partition_all_hits(state, this_c, this_p, x, y, width, height, characters_only, hits);
+    for (int i = 0; i < count; i++) {
+        if (hits[i] < MAX_CHARACTERS) {
+            out[i] = (CollisionEvent){.type = COLLISION_EVENT_TYPE_CHARACTER, .character = character_handle(state, &state->characters[hits[i]])};
+        } else {
+            out[i] = (CollisionEvent){.type = COLLISION_EVENT_TYPE_PROJECTILE, .projectile = projectile_handle(state, &state->projectiles[hits[i] - MAX_CHARACTERS])};
         }
     }
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (&state.projectiles[i] == this_p || !state.projectiles[i].alive) continue;
-        if (aabb(x, y, width, height, state.projectiles[i].physx.x, state.projectiles[i].physx.y, state.projectiles[i].physx.bb_width, state.projectiles[i].physx.bb_height)) {
-            e.type = COLLISION_EVENT_TYPE_PROJECTILE;
-            e.projectile = &state.projectiles[i];
-            return e;
+    return count;
+}
+
+// Slab test of the segment origin + dir * t for t in [0, max_t] against a box, enter is set to the t
+// where it first touches the box
+static bool segment_hits_box(const float origin[2], const float dir[2], float max_t, const float min[2], const float max[2], float *enter) {
+    float t_enter = 0;
+    float t_exit = max_t;
+    for (int axis = 0; axis < 2; axis++) {
+        if (dir[axis] == 0) {
+            if (origin[axis] < min[axis] || origin[axis] > max[axis]) return false;
+            continue;
         }
+        const float t1 = (min[axis] - origin[axis]) / dir[axis];
+        const float t2 = (max[axis] - origin[axis]) / dir[axis];
+        t_enter = fmaxf(t_enter, fminf(t1, t2));
+        t_exit = fminf(t_exit, fmaxf(t1, t2));
+        if (t_enter > t_exit) return false;
     }
+    *enter = t_enter;
+    return true;
+}
 
-    return e;
+// Walks the tile grid from (x, y) along (dir_x, dir_y) (normalized) up to length and stops at the first
+// wall without any of the ignore flags (see wall_ignore_mask). Entities that come within radius of the ray
+// before the wall are written to out (MAX_PHYSICS_OBJECTS big) in ascending order, pass null for out to
+// only check walls, eg for line of sight.
+RaycastResult raycast(GameState *state, Character *this_c, Projectile *this_p, float x, float y, float dir_x, float dir_y, float length, float radius, uint8_t ignore, bool characters_only, CollisionEvent *out) {
+    RaycastResult result = {.distance = length};
+
+    // DDA, t is the distance along the ray to the next column/row boundary
+    const float cell = TILE_SIZE;
+    int32_t column = floorf(x / cell);
+    int32_t row = floorf(y / cell);
+    const int32_t step_x = dir_x > 0 ? 1 : -1;
+    const int32_t step_y = dir_y > 0 ? 1 : -1;
+    const float delta_x = dir_x != 0 ? fabsf(cell / dir_x) : INFINITY;
+    const float delta_y = dir_y != 0 ? fabsf(cell / dir_y) : INFINITY;
+    float next_x = dir_x != 0 ? ((step_x > 0 ? (column + 1) * cell : column * cell) - x) / dir_x : INFINITY;
+    float next_y = dir_y != 0 ? ((step_y > 0 ? (row + 1) * cell : row * cell) - y) / dir_y : INFINITY;
+    float t = 0;
+    while (t < length) {
+        const uint8_t wall = level_tile(state, column, row);
+        COUNT_COLLISION_TESTS(state, 1);
+        if ((wall & TILE_FLAG_SOLID) && !(wall & ignore)) {
+            result.distance = t;
+            result.wall = wall;
+            break;
+        }
+        if (next_x < next_y) {
+            t = next_x;
+            next_x += delta_x;
+            column += step_x;
+        } else {
+            t = next_y;
+            next_y += delta_y;
+            row += step_y;
+        }
+    }
+    if (!out) return result;
+
+    // Entities around the part of the ray that made it, then segment vs their box grown by radius
+    const float end_x = x + (dir_x * result.distance);
+    const float end_y = y + (dir_y * result.distance);
+    const float box_x = fminf(x, end_x) - radius;
+    const float box_y = fminf(y, end_y) - radius;
+    int16_t hits[MAX_PHYSICS_OBJECTS];
+    const int32_t count = partition_all_hits(
+            state, this_c, this_p, box_x, box_y,
+            fabsf(end_x - x) + (radius * 2), fabsf(end_y - y) + (radius * 2),
+            characters_only, hits);
+    const float origin[2] = {x, y};
+    const float dir[2] = {dir_x, dir_y};
+    for (int i = 0; i < count; i++) {
+        const PhysicsObject *physx = partition_physx(state, hits[i]);
+        const float min[2] = {physx->x - radius, physx->y - radius};
+        const float max[2] = {physx->x + physx->bb_width + radius, physx->y + physx->bb_height + radius};
+        float enter;
+        if (!segment_hits_box(origin, dir, result.distance, min, max, &enter)) continue;
+
+        if (hits[i] < MAX_CHARACTERS) {
+            out[result.count++] = (CollisionEvent){.type = COLLISION_EVENT_TYPE_CHARACTER, .character = character_handle(state, &state->characters[hits[i]])};
+        } else {
+            out[result.count++] = (CollisionEvent){.type = COLLISION_EVENT_TYPE_PROJECTILE, .projectile = projectile_handle(state, &state->projectiles[hits[i] - MAX_CHARACTERS])};
+        }
+    }
+
+    return result;
 }
 
-// same as above but walls and projectiles dont count
-CollisionEvent collision_at_no_walls(Character *this_c, Projectile *this_p, float x, float y, float width, float height) {
-    CollisionEvent e = {.type = COLLISION_EVENT_TYPE_NO_COLLISION};
+// Sweeps a physics object along one axis and finds the first wall, character or projectile in the
+// way using the same rules as collision_at. Projectiles pass through characters and vice versa so
+// those are ignored here.
+SweepResult sweep_axis(GameState *state, Character *this_c, Projectile *this_p, const PhysicsObject *physx, float delta, bool vertical) {
+    const float pos = vertical ? physx->y : physx->x;
+    SweepResult result = {.event = {.type = COLLISION_EVENT_TYPE_NO_COLLISION}, .position = pos + delta};
+    if (delta == 0) return result;
+
+    // work in terms of along and across the swept axis
+    const int32_t step = delta > 0 ? 1 : -1;
+    const float size = vertical ? physx->bb_height : physx->bb_width;
+    const float across = vertical ? physx->x : physx->y;
+    const float across_size = vertical ? physx->bb_width : physx->bb_height;
+    const float leading = step > 0 ? pos + size : pos;
+    float best = fabsf(delta);
+    int32_t best_object = -1;
+
+    // Walls, collision_at only looks at the tiles under the corners so only those two lanes matter
+    const float cell = TILE_SIZE;
+    const int32_t lanes[2] = {floorf(across / cell), floorf((across + across_size) / cell)};
+    // an edge exactly on a boundary is in the tile past it as far as collision_at is concerned, so
+    // moving right that tile is the first one ahead and moving left its the one before
+    const int32_t first = step > 0 ? (int32_t)ceilf(leading / cell) : (int32_t)floorf(leading / cell) - 1;
+    const int32_t last = floorf((leading + delta) / cell);
+    const uint8_t ignore = wall_ignore_mask(this_c);
+    for (int32_t i = first; step > 0 ? i <= last : i >= last; i += step) {
+        for (int lane = 0; lane < 2 && !result.event.type; lane++) {
+            const uint8_t wall = vertical ? level_tile(state, lanes[lane], i) : level_tile(state, i, lanes[lane]);
+            COUNT_COLLISION_TESTS(state, 1);
+            if (!(wall & TILE_FLAG_SOLID) || (wall & ignore)) continue;
+
+            const float edge = step > 0 ? i * cell : (i + 1) * cell;
+            best = fmaxf(0, fabsf(edge - leading) - SWEEP_SKIN);
+            result.event.type = wall & TILE_FLAG_BOUNCY ? COLLISION_EVENT_TYPE_BOUNCY_WALL : COLLISION_EVENT_TYPE_WALL;
+            result.event.wall = wall;
+        }
+        if (result.event.type) break;
+    }
 
-    // If no wall collision we will check against all possible physics objects
-    // TODO: THIS MIGHT BE A PERFORMANCE PROBLEM LMAO
-    for (int i = 0; i < MAX_CHARACTERS; i++) {
-        if (&state.characters[i] == this_c || !state.characters[i].alive) continue;
-        if (aabb(x, y, width, height, state.characters[i].physx.x, state.characters[i].physx.y, state.characters[i].physx.bb_width, state.characters[i].physx.bb_height)) {
+    // Anything else we might run into along the way, walls win ties like they do in collision_at
+    int16_t candidates[MAX_PHYSICS_OBJECTS];
+    const float min_pos = fminf(pos, pos + delta);
+    const float max_pos = fmaxf(pos + size, pos + size + delta);
+    const int32_t self = this_c || this_p ? partition_object(state, this_c, this_p) : -1;
+    const int32_t count = vertical ?
+            contact_candidates(state, self, across, min_pos, across_size, max_pos - min_pos, false, candidates) :
+            contact_candidates(state, self, min_pos, across, max_pos - min_pos, across_size, false, candidates);
+    for (int i = 0; i < count; i++) {
+        const int32_t object = candidates[i];
+        if (object == self || !partition_alive(state, object)) continue;
+        if ((this_p && object < MAX_CHARACTERS) || (this_c && object >= MAX_CHARACTERS)) continue;
+        COUNT_COLLISION_TESTS(state, 1);
+
+        const PhysicsObject *other = partition_physx(state, object);
+        const float other_pos = vertical ? other->y : other->x;
+        const float other_size = vertical ? other->bb_height : other->bb_width;
+        const float other_across = vertical ? other->x : other->y;
+        const float other_across_size = vertical ? other->bb_width : other->bb_height;
+        if (!(across < other_across + other_across_size && across + across_size > other_across)) continue;
+
+        // distances along the axis where the two start and stop overlapping
+        const float enter = step > 0 ? other_pos - (pos + size) : pos - (other_pos + other_size);
+        const float exit = step > 0 ? other_pos + other_size - pos : pos + size - other_pos;
+        if (enter >= fabsf(delta)) continue;
+        if (enter < 0 && exit <= fabsf(delta)) continue; // already overlapping and leaving it behind
+
+        const float distance = fmaxf(0, enter - SWEEP_SKIN);
+        if (distance < best || (distance == best && best_object != -1 && object < best_object)) {
+            best = distance;
+            best_object = object;
+        }
+    }
+
+    if (best_object != -1 && best_object < MAX_CHARACTERS) {
+        result.event.type = COLLISION_EVENT_TYPE_CHARACTER;
+        result.event.character = character_handle(state, &state->characters[best_object]);
+    } else if (best_object != -1) {
+        result.event.type = COLLISION_EVENT_TYPE_PROJECTILE;
+        result.event.projectile = projectile_handle(state, &state->projectiles[best_object - MAX_CHARACTERS]);
+    }
+
+    if (result.event.type) {
+        result.position = pos + (best * step);
+        result.normal = -step;
+    }
+    return result;
+}
+
+// First character a projectile passed through on its way from (from_x, from_y) to where it is now.
+// The path is taken as a straight line and each character is grown by the projectile's size so
+// its a segment vs box test, nothing gets skipped over no matter how fast the projectile goes.
+CollisionEvent sweep_projectile(GameState *state, Projectile *projectile, float from_x, float from_y) {
+    CollisionEvent e = {.type = COLLISION_EVENT_TYPE_NO_COLLISION};
+    const PhysicsObject *physx = projectile->physx;
+    const float origin[2] = {from_x, from_y};
+    const float dir[2] = {physx->x - from_x, physx->y - from_y};
+
+    // one query for everything near the whole path
+    int16_t hits[MAX_PHYSICS_OBJECTS];
+    const float box_x = fminf(from_x, physx->x);
+    const float box_y = fminf(from_y, physx->y);
+    const int32_t count = partition_all_hits(
+            state, null, projectile, box_x, box_y,
+            fabsf(dir[0]) + physx->bb_width, fabsf(dir[1]) + physx->bb_height,
+            true, hits);
+
+    // earliest along the path wins, hits are in ascending order so ties go to the lowest
+    float best = INFINITY;
+    for (int i = 0; i < count; i++) {
+        const PhysicsObject *other = partition_physx(state, hits[i]);
+        const float min[2] = {other->x - physx->bb_width, other->y - physx->bb_height};
+        const float max[2] = {other->x + other->bb_width, other->y + other->bb_height};
+        float enter;
+        if (segment_hits_box(origin, dir, 1, min, max, &enter) && enter < best) {
+            best = enter;
             e.type = COLLISION_EVENT_TYPE_CHARACTER;
-            e.character = &state.characters[i];
-            return e;
+            e.character = character_handle(state, &state->characters[hits[i]]);
         }
     }
 
@@ -600,19 +2043,29 @@ CollisionEvent collision_at_no_walls(Character *this_c, Projectile *this_p, floa
 }
 
 // Returns true if a horizontal collision was processed
-bool process_physics(Character *this_c, Projectile *this_p, PhysicsObject *physx, float x_acceleration, float y_acceleration) {
+bool process_physics(GameState *state, Character *this_c, Projectile *this_p, PhysicsObject *physx, float x_acceleration, float y_acceleration) {
     bool collision = false;
 
     // Add acceleration to velocity
     physx->x_vel = oct_Clamp(-SPEED_LIMIT, SPEED_LIMIT, physx->x_vel + x_acceleration);
     physx->y_vel = oct_Clamp(-SPEED_LIMIT, SPEED_LIMIT, physx->y_vel + y_acceleration);
 
-    CollisionEvent ground = collision_at(this_c, this_p, physx->x, physx->y + 1, physx->bb_width, physx->bb_height);
-    const bool kinda_touching_ground = ground.type != 0;
+    // characters already know what they're standing on
+    bool kinda_touching_ground;
+    bool on_ice;
+    if (this_c) {
+        kinda_touching_ground = this_c->contact.grounded;
+        on_ice = this_c->contact.ground_tile & TILE_FLAG_ICE;
+    } else {
+        CollisionEvent ground = collision_at(state, this_c, this_p, physx->x, physx->y + 1, physx->bb_width, physx->bb_height);
+        kinda_touching_ground = ground.type != 0;
+        on_ice = (ground.type == COLLISION_EVENT_TYPE_WALL || ground.type == COLLISION_EVENT_TYPE_BOUNCY_WALL) &&
+                (ground.wall & TILE_FLAG_ICE);
+    }
 
     // Friction and gravity
     if (kinda_touching_ground) {
-        if (ground.wallIndex != 20)
+        if (!on_ice)
             physx->x_vel *= (1 - GROUND_FRICTION);
     } else {
         physx->x_vel *= (1 - AIR_FRICTION);
@@ -622,25 +2075,21 @@ bool process_physics(Character *this_c, Projectile *this_p, PhysicsObject *physx
     if (physx->noclip) {
         physx->x += physx->x_vel;
         physx->y += physx->y_vel;
+        if (this_c || this_p) partition_update(state, partition_object(state, this_c, this_p));
         return false;
     }
 
     // Bouncy dogshit collisions
-    CollisionEvent ce = collision_at(this_c, this_p, physx->x + physx->x_vel, physx->y, physx->bb_width, physx->bb_height);
-    bool counts_as_collision = ce.type;
-    if ((this_p && ce.type == COLLISION_EVENT_TYPE_CHARACTER) || (this_c && ce.type == COLLISION_EVENT_TYPE_PROJECTILE)) {
-        counts_as_collision = false;
-    }
-
-    if (counts_as_collision) {
+    SweepResult sweep = sweep_axis(state, this_c, this_p, physx, physx->x_vel, false);
+    CollisionEvent ce = sweep.event;
+    if (ce.type) {
         // Get close to the wall
-        while (!collision_at(this_c, this_p, physx->x + (sign(physx->x_vel) * 0.1), physx->y, physx->bb_width, physx->bb_height).type)
-            physx->x += (sign(physx->x_vel) * 0.1);
+        physx->x = sweep.position;
 
         // Sound effect when dashing into a wall
         if (physx->x_vel > PARTICLES_GROUND_IMPACT_SPEED) {
-            oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/bumpwall.wav"),
+            play_sound(
+                    state, gAssets[ASSET_SND_BUMPWALL],
                     (Oct_Vec2){0.2 * gSoundVolume, 0.2 * gSoundVolume},
                     false);
         }
@@ -650,10 +2099,10 @@ bool process_physics(Character *this_c, Projectile *this_p, PhysicsObject *physx
             physx->x_vel = physx->x_vel * (-BOUNCE_PRESERVED_BOUNCE_WALL);
         } else {
             if (ce.type == COLLISION_EVENT_TYPE_CHARACTER) {
-                ce.character->physx.x_vel += physx->x_vel;
+                character_get(state, ce.character)->physx->x_vel += physx->x_vel;
             }
             if (ce.type == COLLISION_EVENT_TYPE_PROJECTILE) {
-                ce.projectile->physx.x_vel += physx->x_vel;
+                projectile_get(state, ce.projectile)->physx->x_vel += physx->x_vel;
             }
             physx->x_vel = physx->x_vel * (-BOUNCE_PRESERVED);
         }
@@ -661,31 +2110,27 @@ bool process_physics(Character *this_c, Projectile *this_p, PhysicsObject *physx
     }
     physx->x += physx->x_vel;
 
-    ce = collision_at(this_c, this_p, physx->x, physx->y + physx->y_vel, physx->bb_width, physx->bb_height);
-    counts_as_collision = ce.type;
-    if ((this_p && ce.type == COLLISION_EVENT_TYPE_CHARACTER) || (this_c && ce.type == COLLISION_EVENT_TYPE_PROJECTILE)) {
-        counts_as_collision = false;
-    }
-    if (counts_as_collision) {
+    sweep = sweep_axis(state, this_c, this_p, physx, physx->y_vel, true);
+    ce = sweep.event;
+    if (ce.type) {
         // Get close to the wall
-        while (!collision_at(this_c, this_p, physx->x, physx->y + (sign(physx->y_vel) * 0.1), physx->bb_width, physx->bb_height).type)
-            physx->y += (sign(physx->y_vel) * 0.1);
+        physx->y = sweep.position;
 
         // Particles cuz you hit the ground hard
         if (physx->y_vel > PARTICLES_GROUND_IMPACT_SPEED) {
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                 .variation = 1,
                 .y_vel = -2,
                 .x_vel = 0,
-                .tex = oct_GetAsset(gBundle, "textures/garbageparticle.png"),
-                .spr = OCT_NO_ASSET,
+                .tex = ASSET_TEX_GARBAGEPARTICLE,
+                .spr = ASSET_NONE,
                 .x = physx->x + (physx->bb_width / 2),
                 .y = physx->y + physx->bb_height,
                 .count = 10,
                 .lifetime = 1
             });
-            oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/bumpwall.wav"),
+            play_sound(
+                    state, gAssets[ASSET_SND_BUMPWALL],
                     (Oct_Vec2){0.2 * gSoundVolume, 0.2 * gSoundVolume},
                     false);
         }
@@ -695,32 +2140,53 @@ bool process_physics(Character *this_c, Projectile *this_p, PhysicsObject *physx
             physx->y_vel = physx->y_vel * (-BOUNCE_PRESERVED_BOUNCE_WALL);
         } else {
             if (ce.type == COLLISION_EVENT_TYPE_CHARACTER) {
-                ce.character->physx.y_vel += physx->y_vel;
+                character_get(state, ce.character)->physx->y_vel += physx->y_vel;
             }
             if (ce.type == COLLISION_EVENT_TYPE_PROJECTILE) {
-                ce.projectile->physx.y_vel += physx->y_vel;
+                projectile_get(state, ce.projectile)->physx->y_vel += physx->y_vel;
             }
             physx->y_vel = physx->y_vel * (-BOUNCE_PRESERVED);
         }
     }
     physx->y += physx->y_vel;
+    if (this_c || this_p) partition_update(state, partition_object(state, this_c, this_p));
     return collision;
 }
 
-void draw_character(Character *character) {
+// Fills out character->contact for this frame
+void update_contacts(GameState *state, Character *character) {
+    const PhysicsObject *physx = character->physx;
+    ContactState *contact = &character->contact;
+    *contact = (ContactState){0};
+
+    const CollisionEvent ground = collision_at(state, character, null, physx->x, physx->y + GROUND_PROBE_DISTANCE, physx->bb_width, physx->bb_height);
+    contact->grounded = ground.type != COLLISION_EVENT_TYPE_NO_COLLISION;
+    if (ground.type == COLLISION_EVENT_TYPE_WALL || ground.type == COLLISION_EVENT_TYPE_BOUNCY_WALL)
+        contact->ground_tile = ground.wall;
+
+    // dashers punch whoever is next to them
+    if (contact->grounded && character->type == CHARACTER_TYPE_DASHER && !character->player_controlled) {
+        const CollisionEvent right = collision_at(state, character, null, physx->x + physx->bb_width, physx->y, physx->bb_width, physx->bb_height);
+        const CollisionEvent left = collision_at(state, character, null, physx->x - physx->bb_width, physx->y, physx->bb_width, physx->bb_height);
+        contact->right = right.type == COLLISION_EVENT_TYPE_CHARACTER ? right.character : 0;
+        contact->left = left.type == COLLISION_EVENT_TYPE_CHARACTER ? left.character : 0;
+    }
+}
+
+void draw_character(GameState *state, Character *character) {
     // for iframes
     Oct_Colour c = {1, 1, 1, 1};
-    if (character->player_controlled && state.player_iframes > 0 && (state.player_iframes % 2 == 0)) {
+    if (character->player_controlled && state->player_iframes > 0 && (state->player_iframes % 2 == 0)) {
         c.a = 0;
     }
 
     // draw fire effect when time to level up or whatever its called
-    if (character->player_controlled && NEAR_LEVEL_UP) {
+    if (character->player_controlled && NEAR_LEVEL_UP(state)) {
         // 49, 95
         oct_DrawSpriteInt(
                 OCT_INTERPOLATE_ALL, 666,
-                oct_GetAsset(gBundle, "sprites/fire.json"), &state.fire,
-                (Oct_Vec2){character->physx.x - 33 + (character->physx.bb_width / 2), character->physx.y - 80 + character->physx.bb_height});
+                gAssets[ASSET_SPR_FIRE], &state->fire,
+                (Oct_Vec2){character->physx->x - 33 + (character->physx->bb_width / 2), character->physx->y - 80 + character->physx->bb_height});
     }
 
     // paper mario effect
@@ -728,456 +2194,523 @@ void draw_character(Character *character) {
 
     // Draw telegraphing effect
     if (character->wants_to_action && !character->player_controlled) {
-        const float x = character->physx.x + (character->physx.bb_width / 2) - 8.5;
+        const float x = character->physx->x + (character->physx->bb_width / 2) - 8.5;
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, character->id + 4,
-                oct_GetAsset(gBundle, "textures/angry.png"),
-                (Oct_Vec2){x, character->physx.y - 17}
+                gAssets[ASSET_TEX_ANGRY],
+                (Oct_Vec2){x, character->physx->y - 17}
                 );
     }
 
     if (character->type == CHARACTER_TYPE_JUMPER || character->type == CHARACTER_TYPE_BOMBER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 character_type_sprite(character),
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } else if (character->type == CHARACTER_TYPE_LASER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
         character->mouth_open -= 1;
-        const Oct_Sprite spr = character->mouth_open > 0 ? oct_GetAsset(gBundle, "sprites/playerlaseropen.json") : character_type_sprite(character);
+        const Oct_Sprite spr = character->mouth_open > 0 ? gAssets[ASSET_SPR_PLAYERLASEROPEN] : character_type_sprite(character);
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 spr,
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } else if (character->type == CHARACTER_TYPE_X_SHOOTER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
-        const float gun_x = character->facing == 1 ? (character->physx.x + character->physx.bb_width) : character->physx.x;
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
+        const float gun_x = character->facing == 1 ? (character->physx->x + character->physx->bb_width) : character->physx->x;
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 character_type_sprite(character),
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
         oct_DrawTextureIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id + 3,
-                oct_GetAsset(gBundle, "textures/gun.png"),
+                gAssets[ASSET_TEX_GUN],
                 &c,
-                (Oct_Vec2) {gun_x, character->physx.y - 8},
+                (Oct_Vec2) {gun_x, character->physx->y - 8},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } else if (character->type == CHARACTER_TYPE_XY_SHOOTER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
-        const float gun_x = character->facing == 1 ? (character->physx.x + character->physx.bb_width - 4) : character->physx.x + 4;
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
+        const float gun_x = character->facing == 1 ? (character->physx->x + character->physx->bb_width - 4) : character->physx->x + 4;
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 character_type_sprite(character),
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
         oct_DrawTextureIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id + 3,
-                oct_GetAsset(gBundle, "textures/xygun.png"),
+                gAssets[ASSET_TEX_XYGUN],
                 &c,
-                (Oct_Vec2) {gun_x, character->physx.y - 16},
+                (Oct_Vec2) {gun_x, character->physx->y - 16},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } else if (character->type == CHARACTER_TYPE_Y_SHOOTER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
-        const float gun_x = character->facing == 1 ? (x + (character->physx.bb_width / 2) - (19 / 2)) : (x + (character->physx.bb_width / 2) - (19 / 2) + 6);
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
+        const float gun_x = character->facing == 1 ? (x + (character->physx->bb_width / 2) - (19 / 2)) : (x + (character->physx->bb_width / 2) - (19 / 2) + 6);
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 character_type_sprite(character),
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
         oct_DrawTextureIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id + 3,
-                oct_GetAsset(gBundle, "textures/ygun.png"),
+                gAssets[ASSET_TEX_YGUN],
                 &c,
-                (Oct_Vec2) {gun_x, character->physx.y - 23},
+                (Oct_Vec2) {gun_x, character->physx->y - 23},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } else if (character->type == CHARACTER_TYPE_DASHER) {
-        const float x = character->facing == 1 ? character->physx.x : (character->physx.x + character->physx.bb_width);
-        const float gun_x = character->facing == 1 ? (character->physx.x + character->physx.bb_width) : character->physx.x;
-        const float gun2_x = character->facing == -1 ? (character->physx.x + character->physx.bb_width) : character->physx.x;
+        const float x = character->facing == 1 ? character->physx->x : (character->physx->x + character->physx->bb_width);
+        const float gun_x = character->facing == 1 ? (character->physx->x + character->physx->bb_width) : character->physx->x;
+        const float gun2_x = character->facing == -1 ? (character->physx->x + character->physx->bb_width) : character->physx->x;
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id,
                 character_type_sprite(character),
                 &character->sprite,
                 &c,
-                (Oct_Vec2) {x, character->physx.y},
+                (Oct_Vec2) {x, character->physx->y},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
         oct_DrawTextureIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id + 3,
-                oct_GetAsset(gBundle, "textures/jacked.png"),
+                gAssets[ASSET_TEX_JACKED],
                 &c,
-                (Oct_Vec2) {gun_x, character->physx.y - 4},
+                (Oct_Vec2) {gun_x, character->physx->y - 4},
                 (Oct_Vec2){character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
         oct_DrawTextureIntColourExt(
                 OCT_INTERPOLATE_ALL, character->id + 5,
-                oct_GetAsset(gBundle, "textures/jacked.png"),
+                gAssets[ASSET_TEX_JACKED],
                 &c,
-                (Oct_Vec2) {gun2_x, character->physx.y - 4},
+                (Oct_Vec2) {gun2_x, character->physx->y - 4},
                 (Oct_Vec2){-character->shown_facing, 1},
                 0, (Oct_Vec2){0, 0});
     } // TODO: The rest of these
 }
-void kill_character(bool player_is_killer, Character *character, bool dramatic);
+void kill_character(GameState *state, bool player_is_killer, Character *character, bool dramatic);
+
+// Kills every character in victims, for attacks that hit everything they touch
+void kill_all(GameState *state, Character *killer, CollisionEvent *victims, int32_t count, bool dramatic) {
+    for (int i = 0; i < count; i++) {
+        // the killer can take someone's body partway through, which kills the killer's old body
+        Character *victim = character_get(state, victims[i].character);
+        if (victim)
+            kill_character(state, killer->player_controlled, victim, dramatic);
+    }
+}
+
+void kill_region(GameState *state, Character *killer, float x, float y, float width, float height, bool dramatic) {
+    CollisionEvent victims[MAX_PHYSICS_OBJECTS];
+    const int32_t count = collision_region(state, killer, null, x, y, width, height, true, victims);
+    kill_all(state, killer, victims, count, dramatic);
+}
 
 // bwah
-void imma_firin_muh_lazor(Character *character) {
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/laser.wav"),
+void imma_firin_muh_lazor(GameState *state, Character *character) {
+    play_sound(
+            state, gAssets[ASSET_SND_LASER],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             0);
-    create_particles_job(&(CreateParticlesJob) {
+
+    // the beam stops at the first wall, the texture is LASER_LENGTH long so its squished to match
+    CollisionEvent victims[MAX_PHYSICS_OBJECTS];
+    const RaycastResult beam = raycast(
+            state, character, null,
+            character->physx->x + (character->physx->bb_width / 2),
+            character->physx->y + (character->physx->bb_height / 2),
+            character->facing == -1 ? -1 : 1, 0,
+            LASER_LENGTH, LASER_HALF_THICKNESS, wall_ignore_mask(character), true, victims);
+    create_particles_job(state, &(CreateParticlesJob) {
             .lifetime = 0.8,
             .count = 1,
             .variation = 1,
-            .spr = OCT_NO_ASSET,
-            .tex = oct_GetAsset(gBundle, "textures/lazer.png"),
-            .x = character->physx.x + (character->physx.bb_width / 2) - (character->facing == -1 ? 512 : 0),
-            .y = character->physx.y + (character->physx.bb_height / 2) - 4,
+            .spr = ASSET_NONE,
+            .tex = ASSET_TEX_LAZER,
+            .x = character->physx->x + (character->physx->bb_width / 2) - (character->facing == -1 ? beam.distance : 0),
+            .y = character->physx->y + (character->physx->bb_height / 2) - 4,
             .y_vel = -2,
-            .x_vel = (character->facing == -1 ? 3 : 3)
+            .x_vel = (character->facing == -1 ? 3 : 3),
+            .x_scale = beam.distance / LASER_LENGTH
     });
-    for (int i = 0 ; i < 10; i++) {
-        CollisionEvent kaboom = collision_at_no_walls(
-                character, null,
-                character->physx.x + (character->physx.bb_width / 2) - (character->facing == -1 ? 512 : 0),
-                character->physx.y - (character->physx.bb_width / 2) - 8,
-                512,
-                16);
-        if (kaboom.type == COLLISION_EVENT_TYPE_CHARACTER) {
-            kill_character(character->player_controlled, kaboom.character, true);
-        }
-    }
+    kill_all(state, character, victims, beam.count, true);
     character->mouth_open = MOUTH_OPEN_DURATION;
 }
 
 // blow the fuck up
-void blow_up(Character *character) {
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/kaboom.wav"),
+void blow_up(GameState *state, Character *character) {
+    play_sound(
+            state, gAssets[ASSET_SND_KABOOM],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             0);
-    create_particles_job(&(CreateParticlesJob) {
+    create_particles_job(state, &(CreateParticlesJob) {
             .lifetime = 0.8,
             .count = 1,
             .variation = 0,
-            .spr = oct_GetAsset(gBundle, "sprites/kaboom.json"),
-            .tex = OCT_NO_ASSET,
-            .x = character->physx.x + (character->physx.bb_width / 2) - 64,
-            .y = character->physx.y + (character->physx.bb_height / 2) - 64,
+            .spr = ASSET_SPR_KABOOM,
+            .tex = ASSET_NONE,
+            .x = character->physx->x + (character->physx->bb_width / 2) - 64,
+            .y = character->physx->y + (character->physx->bb_height / 2) - 64,
             .y_vel = -2,
             .x_vel = 3
     });
-    for (int i = 0 ; i < 10; i++) {
-        CollisionEvent kaboom = collision_at_no_walls(
-                character, null,
-                character->physx.x - (character->physx.bb_width / 2) - BOMBER_BLAST_RADIUS,
-                character->physx.y - (character->physx.bb_width / 2) - BOMBER_BLAST_RADIUS,
-                BOMBER_BLAST_RADIUS * 2,
-                BOMBER_BLAST_RADIUS * 2);
-        if (kaboom.type == COLLISION_EVENT_TYPE_CHARACTER) {
-            kill_character(character->player_controlled, kaboom.character, true);
-        }
+    kill_region(
+            state, character,
+            character->physx->x - (character->physx->bb_width / 2) - BOMBER_BLAST_RADIUS,
+            character->physx->y - (character->physx->bb_width / 2) - BOMBER_BLAST_RADIUS,
+            BOMBER_BLAST_RADIUS * 2,
+            BOMBER_BLAST_RADIUS * 2,
+            true);
+}
+
+// reads the keyboard and gamepad
+FrameInput read_input_devices() {
+    FrameInput input = {0};
+
+    if (oct_KeyDown(OCT_KEY_LEFT) || oct_GamepadButtonDown(0, OCT_GAMEPAD_BUTTON_DPAD_LEFT))
+        input.buttons |= INPUT_LEFT;
+    if (oct_KeyDown(OCT_KEY_RIGHT) || oct_GamepadButtonDown(0, OCT_GAMEPAD_BUTTON_DPAD_RIGHT))
+        input.buttons |= INPUT_RIGHT;
+    if (oct_KeyPressed(OCT_KEY_UP) || oct_GamepadButtonPressed(0, OCT_GAMEPAD_BUTTON_A))
+        input.buttons |= INPUT_JUMP;
+    if (oct_KeyPressed(OCT_KEY_SPACE) || oct_GamepadButtonPressed(0, OCT_GAMEPAD_BUTTON_X))
+        input.buttons |= INPUT_ACTION;
+    if (oct_KeyPressed(OCT_KEY_SPACE))
+        input.buttons |= INPUT_CONFIRM;
+    if (oct_KeyDown(OCT_KEY_F))
+        input.buttons |= INPUT_QUIT;
+    if (oct_KeyPressed(OCT_KEY_Q))
+        input.buttons |= INPUT_SPAWN_DASHER;
+    if (oct_KeyPressed(OCT_KEY_E))
+        input.buttons |= INPUT_SPAWN_LASER;
+    if (oct_KeyPressed(OCT_KEY_R))
+        input.buttons |= INPUT_SPAWN_BOMBER;
+
+    // the deadzone keeps anything that matters well clear of rounding to 0
+    input.axis_x = (int8_t)roundf(oct_Clamp(-1, 1, oct_GamepadLeftAxisX(0)) * 127);
+    return input;
+}
+
+// this frame's input from the replay being played or the devices, headless runs have nobody at the controls
+FrameInput poll_input(GameState *state) {
+    FrameInput input = {0};
+    Replay *replay = state->replay;
+    if (replay && replay->mode == REPLAY_MODE_PLAYING) {
+        if (replay->cursor < replay->count)
+            input = replay->frames[replay->cursor++];
+        return input;
     }
+
+    if (!gHeadless)
+        input = read_input_devices();
+    if (replay && replay->mode == REPLAY_MODE_RECORDING)
+        replay_push(replay, input);
+    return input;
 }
 
-void shoot_x_bullet(Character *character);
-void shoot_y_bullet(Character *character);
-void shoot_xy_bullet(Character *character);
-InputProfile process_player(Character *character) {
+void shoot_x_bullet(GameState *state, Character *character);
+void shoot_y_bullet(GameState *state, Character *character);
+void shoot_xy_bullet(GameState *state, Character *character);
+InputProfile process_player(GameState *state, Character *character) {
     InputProfile input = {0};
+    const FrameInput *keys = &state->input;
 
-    if (state.player_died) return input;
-    state.player_iframes -= 1;
-    if (oct_KeyDown(OCT_KEY_LEFT) || oct_GamepadButtonDown(0, OCT_GAMEPAD_BUTTON_DPAD_LEFT) ||
-        oct_GamepadLeftAxisX(0) < 0) {
+    if (state->player_died) return input;
+    state->player_iframes -= 1;
+    if ((keys->buttons & INPUT_LEFT) || keys->axis_x < 0) {
         input.x_acc = -(ACCELERATION_VALUES[character->type] * PLAYER_SPEED_FACTOR);
-    } else if (oct_KeyDown(OCT_KEY_RIGHT) || oct_GamepadButtonDown(0, OCT_GAMEPAD_BUTTON_DPAD_RIGHT) ||
-               oct_GamepadLeftAxisX(0) > 0) {
+    } else if ((keys->buttons & INPUT_RIGHT) || keys->axis_x > 0) {
         input.x_acc = (ACCELERATION_VALUES[character->type] * PLAYER_SPEED_FACTOR);
     }
-    const bool kinda_touching_ground = collision_at(character, null, character->physx.x, character->physx.y + 2, character->physx.bb_width, character->physx.bb_height).type;
+    const bool kinda_touching_ground = character->contact.grounded;
 
     // jumping (player can always jump)
-    if (kinda_touching_ground && (oct_KeyPressed(OCT_KEY_UP) || oct_GamepadButtonPressed(0, OCT_GAMEPAD_BUTTON_A))) {
+    if (kinda_touching_ground && (keys->buttons & INPUT_JUMP)) {
         input.y_acc = -PLAYER_JUMP_SPEED;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/jump.wav"),
+        play_sound(
+                state, gAssets[ASSET_SND_JUMP],
                 (Oct_Vec2){0.5 * gSoundVolume, 0.5 * gSoundVolume},
                 false);
     }
 
     // action depending on type of entity
-    if (oct_KeyPressed(OCT_KEY_SPACE) || oct_GamepadButtonPressed(0, OCT_GAMEPAD_BUTTON_X)) {
+    if (keys->buttons & INPUT_ACTION) {
         if (character->type == CHARACTER_TYPE_JUMPER) {
             input.y_acc = JUMPER_DESCEND_SPEED;
         } else if (character->type == CHARACTER_TYPE_LASER) {
-            imma_firin_muh_lazor(character);
+            imma_firin_muh_lazor(state, character);
         } else if (character->type == CHARACTER_TYPE_X_SHOOTER) {
-            shoot_x_bullet(character);
+            shoot_x_bullet(state, character);
         } else if (character->type == CHARACTER_TYPE_Y_SHOOTER) {
-            shoot_y_bullet(character);
+            shoot_y_bullet(state, character);
         } else if (character->type == CHARACTER_TYPE_XY_SHOOTER) {
-            shoot_xy_bullet(character);
+            shoot_xy_bullet(state, character);
         } else if (character->type == CHARACTER_TYPE_DASHER && kinda_touching_ground) {
-            oct_PlaySound(oct_GetAsset(gBundle, "sounds/punch.wav"),
-                          (Oct_Vec2) {1 * gSoundVolume, 1 * gSoundVolume}, false);
-            character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-            CollisionEvent bigass = collision_at_no_walls(character, null, character->physx.x - (character->physx.bb_width * 1.5), character->physx.y-20, character->physx.bb_width * 4, character->physx.bb_height + 16);
-            if (bigass.type == COLLISION_EVENT_TYPE_CHARACTER) {
-                bigass.character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-                kill_character(true, bigass.character, true);
+            play_sound(state, gAssets[ASSET_SND_PUNCH],
+                       (Oct_Vec2) {1 * gSoundVolume, 1 * gSoundVolume}, false);
+            character->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+            CollisionEvent bigass[MAX_PHYSICS_OBJECTS];
+            const int32_t count = collision_region(state, character, null, character->physx->x - (character->physx->bb_width * 1.5), character->physx->y-20, character->physx->bb_width * 4, character->physx->bb_height + 16, true, bigass);
+            for (int i = 0; i < count; i++) {
+                Character *victim = character_get(state, bigass[i].character);
+                if (!victim) continue;
+                victim->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+                kill_character(state, true, victim, true);
             }
         } else if (character->type == CHARACTER_TYPE_BOMBER) {
-            blow_up(character);
-            kill_character(false, character, false);
+            blow_up(state, character);
+            kill_character(state, false, character, false);
         }
     }
 
     // dont fall off edge
-    if (character->physx.y > GAME_HEIGHT) {
-        character->physx.x = 15.5 * 16;
-        character->physx.y = 11 * 16;
+    if (character->physx->y > GAME_HEIGHT) {
+        character->physx->x = 15.5 * 16;
+        character->physx->y = 11 * 16;
+        partition_update(state, partition_object(state, character, null));
+        contacts_late(state, partition_object(state, character, null));
     }
 
     return input;
 }
 
 // transforms the player into this dude
-void take_body(Character *character) {
+void take_body(GameState *state, Character *character) {
     // reset kills and show a nice particle effect
-    state.req_kills_accumulator++;
-    if (state.req_kills_accumulator == REQ_KILLS_ACCUMULATOR) {
-        state.req_kills_accumulator = 0;
-        state.req_kills++;
-    }
-    state.player_transform_time = state.total_time;
-    state.current_kills = 0;
-    create_particles_job(&(CreateParticlesJob){
+    state->req_kills_accumulator++;
+    if (state->req_kills_accumulator == REQ_KILLS_ACCUMULATOR) {
+        state->req_kills_accumulator = 0;
+        state->req_kills++;
+    }
+    state->player_transform_time = state->total_time;
+    state->current_kills = 0;
+    create_particles_job(state, &(CreateParticlesJob){
             .lifetime = 3,
             .count = 10,
             .variation = 1,
-            .spr = OCT_NO_ASSET,
-            .tex = oct_GetAsset(gBundle, "textures/thumbsup.png"),
+            .spr = ASSET_NONE,
+            .tex = ASSET_TEX_THUMBSUP,
             .x = GAME_WIDTH / 2,
             .y = 48,
             .y_vel = -2
     });
-    state.player_iframes = PLAYER_I_FRAMES;
+    state->player_iframes = PLAYER_I_FRAMES;
 
     // Take dudes body
-    Character *player = state.player;
-    state.player = character;
+    Character *player = character_get(state, state->player);
     character->player_controlled = true;
-    character->alive = true;
-    state.max_lifespan = CHARACTER_TYPE_LIFESPANS[character->type];
-    state.lifespan = CHARACTER_TYPE_LIFESPANS[character->type];
-
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/transform.wav"),
+    // kill_character might have already given the body back to the pool
+    pool_reclaim(&state->character_pool, character - state->characters);
+    state->player = character_handle(state, character);
+    state->max_lifespan = CHARACTER_TYPE_LIFESPANS[character->type];
+    state->lifespan = CHARACTER_TYPE_LIFESPANS[character->type];
+
+    play_sound(
+            state, gAssets[ASSET_SND_TRANSFORM],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             false);
 
     // kill old player
-    player->player_controlled = false;
-    kill_character(false, player, true);
+    if (player) {
+        player->player_controlled = false;
+        kill_character(state, false, player, true);
+    }
 }
 
 // shoot horizontal bullet
-void shoot_x_bullet(Character *character) {
-    const float x = character->facing == 1 ? character->physx.x + character->physx.bb_width + 10 : character->physx.x -12;
+void shoot_x_bullet(GameState *state, Character *character) {
+    const float x = character->facing == 1 ? character->physx->x + character->physx->bb_width + 10 : character->physx->x -12;
     create_projectile(
-            character->player_controlled,
-            oct_GetAsset(gBundle, "textures/bullet.png"),
+            state, character->player_controlled,
+            ASSET_TEX_BULLET,
             X_SHOOTER_BULLET_LIFETIME,
             x,
-            character->physx.y,
+            character->physx->y,
             X_SHOOTER_BULLET_SPEED * character->facing,
             0);
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/gunshot.wav"),
+    play_sound(
+            state, gAssets[ASSET_SND_GUNSHOT],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             false);
-    character->physx.x_vel -= X_SHOOTER_RECOIL * character->facing;
+    character->physx->x_vel -= X_SHOOTER_RECOIL * character->facing;
 }
 
 // shoot vertical bullet
-void shoot_y_bullet(Character *character) {
-    const float x = character->physx.x + (character->physx.bb_width / 2);
+void shoot_y_bullet(GameState *state, Character *character) {
+    const float x = character->physx->x + (character->physx->bb_width / 2);
     create_projectile(
-            character->player_controlled,
-            oct_GetAsset(gBundle, "textures/bullet.png"),
+            state, character->player_controlled,
+            ASSET_TEX_BULLET,
             Y_SHOOTER_BULLET_LIFETIME,
             x,
-            character->physx.y - 10,
+            character->physx->y - 10,
             0,
             -Y_SHOOTER_BULLET_SPEED);
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/gunshot.wav"),
+    play_sound(
+            state, gAssets[ASSET_SND_GUNSHOT],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             false);
 }
 
 // shoot diagonal bullet
-void shoot_xy_bullet(Character *character) {
-    const float x = character->facing == 1 ? character->physx.x + character->physx.bb_width + 10 : character->physx.x -12;
+void shoot_xy_bullet(GameState *state, Character *character) {
+    const float x = character->facing == 1 ? character->physx->x + character->physx->bb_width + 10 : character->physx->x -12;
     create_projectile(
-            character->player_controlled,
-            oct_GetAsset(gBundle, "textures/bullet.png"),
+            state, character->player_controlled,
+            ASSET_TEX_BULLET,
             XY_SHOOTER_BULLET_LIFETIME,
             x,
-            character->physx.y - 10,
+            character->physx->y - 10,
             XY_SHOOTER_BULLET_SPEED * character->facing,
             -XY_SHOOTER_BULLET_SPEED);
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/gunshot.wav"),
+    play_sound(
+            state, gAssets[ASSET_SND_GUNSHOT],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             false);
-    character->physx.x_vel -= XY_SHOOTER_RECOIL * character->facing;
+    character->physx->x_vel -= XY_SHOOTER_RECOIL * character->facing;
 }
 
 // checks if the user got a highscore and records it if so
-void check_highscore() {
+void check_highscore(GameState *state) {
+    // leave the real save file alone, a replay's score was already counted when it was played
+    if (gHeadless || (state->replay && state->replay->mode == REPLAY_MODE_PLAYING)) return;
     Save save = parse_save();
-    if (save.highscore[menu_state.map] < state.score) {
-        state.got_highscore = true;
-        save.highscore[menu_state.map] = state.score;
+    if (save.highscore[state->map] < state->score) {
+        state->got_highscore = true;
+        save.highscore[state->map] = state->score;
         save_game(&save);
         // todo - possible global leaderboard
     }
 }
 
-void kill_character(bool player_is_the_killer, Character *character, bool dramatic) {
+void kill_character(GameState *state, bool player_is_the_killer, Character *character, bool dramatic) {
     if (!character->player_controlled) {
-        character->alive = false;
-        create_particles_job(&(CreateParticlesJob){
+        release_character(state, character);
+        create_particles_job(state, &(CreateParticlesJob){
             .lifetime = 3,
             .count = 1,
             .variation = dramatic ? 3 : 1,
-            .spr = character_type_sprite(character),
-            .tex = OCT_NO_ASSET,
-            .x = character->physx.x,
-            .y = character->physx.y,
+            .spr = character_type_sprite_id(character),
+            .tex = ASSET_NONE,
+            .x = character->physx->x,
+            .y = character->physx->y,
             .y_vel = dramatic ? -10 : -2
         });
 
         // small sound
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/jumpenemy.wav"),
+        play_sound(
+                state, gAssets[ASSET_SND_JUMPENEMY],
                 (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
                 false);
 
-        create_particles_job(&(CreateParticlesJob){
+        create_particles_job(state, &(CreateParticlesJob){
                 .lifetime = 3,
                 .count = dramatic ? 20 : 8,
                 .variation = dramatic ? 3 : 1,
-                .spr = OCT_NO_ASSET,
-                .tex = oct_GetAsset(gBundle, "textures/blood.png"),
-                .x = character->physx.x + (character->physx.bb_width / 2),
-                .y = character->physx.y + (character->physx.bb_height / 2),
+                .spr = ASSET_NONE,
+                .tex = ASSET_TEX_BLOOD,
+                .x = character->physx->x + (character->physx->bb_width / 2),
+                .y = character->physx->y + (character->physx->bb_height / 2),
                 .y_vel = -2
         });
 
         if (player_is_the_killer) {
-            state.current_kills += 1;
-            if (state.current_kills >= state.req_kills) {
-                take_body(character);
+            state->kills += 1;
+            state->current_kills += 1;
+            if (state->current_kills >= state->req_kills) {
+                take_body(state, character);
             }
         }
-        if (!state.player_died) {
-            state.score += ADDITIONAL_SCORE[character->type];
+        if (!state->player_died) {
+            state->score += ADDITIONAL_SCORE[character->type];
         }
-    } else if (state.player_iframes <= 0 && !state.player_died && !state.in_tutorial) {
-        state.player_iframes = PLAYER_I_FRAMES;
-        if (state.lifespan <= 0) {
-            oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/die.wav"),
+    } else if (state->player_iframes <= 0 && !state->player_died && !state->in_tutorial) {
+        state->player_iframes = PLAYER_I_FRAMES;
+        if (state->lifespan <= 0) {
+            play_sound(
+                    state, gAssets[ASSET_SND_DIE],
                     (Oct_Vec2) {1 * gSoundVolume, 1 * gSoundVolume},
                     false);
 
-            create_particles_job(&(CreateParticlesJob) {
+            create_particles_job(state, &(CreateParticlesJob) {
                     .lifetime = 0.8,
                     .count = 1,
                     .variation = 0,
-                    .spr = oct_GetAsset(gBundle, "sprites/explosion.json"),
-                    .tex = OCT_NO_ASSET,
-                    .x = character->physx.x + (character->physx.bb_width / 2) - 20,
-                    .y = character->physx.y + (character->physx.bb_height / 2) - 20,
+                    .spr = ASSET_SPR_EXPLOSION,
+                    .tex = ASSET_NONE,
+                    .x = character->physx->x + (character->physx->bb_width / 2) - 20,
+                    .y = character->physx->y + (character->physx->bb_height / 2) - 20,
                     .y_vel = -2
             });
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                     .lifetime = 3,
                     .count = 1,
                     .variation = dramatic ? 3 : 1,
-                    .spr = character_type_sprite(character),
-                    .tex = OCT_NO_ASSET,
-                    .x = character->physx.x,
-                    .y = character->physx.y,
+                    .spr = character_type_sprite_id(character),
+                    .tex = ASSET_NONE,
+                    .x = character->physx->x,
+                    .y = character->physx->y,
                     .y_vel = -2
             });
             character->player_controlled = false;
-            character->alive = false;
-            state.player_died = true;
-            state.player_die_time = state.total_time;
-            check_highscore();
+            release_character(state, character);
+            state->player_died = true;
+            state->player_die_time = state->total_time;
+            check_highscore(state);
         } else {
-            state.lifespan *= 0.75;
+            state->lifespan *= 0.75;
 
-            oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/jumpenemy.wav"),
+            play_sound(
+                    state, gAssets[ASSET_SND_JUMPENEMY],
                     (Oct_Vec2) {1 * gSoundVolume, 1 * gSoundVolume},
                     false);
 
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                     .lifetime = 3,
                     .count = 8,
                     .variation = 1,
-                    .spr = OCT_NO_ASSET,
-                    .tex = oct_GetAsset(gBundle, "textures/blood.png"),
-                    .x = character->physx.x + (character->physx.bb_width / 2),
-                    .y = character->physx.y + (character->physx.bb_height / 2),
+                    .spr = ASSET_NONE,
+                    .tex = ASSET_TEX_BLOOD,
+                    .x = character->physx->x + (character->physx->bb_width / 2),
+                    .y = character->physx->y + (character->physx->bb_height / 2),
                     .y_vel = -2
             });
         }
     }
 }
 
-InputProfile pre_process_ai(Character *character) {
+InputProfile pre_process_ai(GameState *state, Character *character) {
     InputProfile input = {0};
 
     // Get input from ai
     input.x_acc = ACCELERATION_VALUES[character->type] * character->direction;
-    const bool kinda_touching_ground = collision_at(character, null, character->physx.x, character->physx.y + 2, character->physx.bb_width, character->physx.bb_height).type != 0;
+    const bool kinda_touching_ground = character->contact.grounded;
 
     // Jumpers might jump every now and again
     if (character->type == CHARACTER_TYPE_JUMPER) {
-        if (gFrameCounter % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
-            oct_Random(0, 1) < ACTION_CHANCE[character->type] &&
+        if (state->frame % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
+            rng_float(state, RNG_STREAM_AI, 0, 1) < ACTION_CHANCE[character->type] &&
             kinda_touching_ground &&
             character->action_timer <= ACTION_COOLDOWNS[character->type] &&
-            character->physx.y + character->physx.bb_height > 3 * 16) {
+            character->physx->y + character->physx->bb_height > 3 * 16) {
 
             character->wants_to_action = true;
             character->action_timer = ACTION_TELEGRAPH_TIMES[character->type];
@@ -1188,11 +2721,11 @@ InputProfile pre_process_ai(Character *character) {
             character->wants_to_action = false;
         }
     } else if (character->type == CHARACTER_TYPE_X_SHOOTER || character->type == CHARACTER_TYPE_Y_SHOOTER || character->type == CHARACTER_TYPE_XY_SHOOTER) {
-        if (gFrameCounter % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
-            oct_Random(0, 1) < ACTION_CHANCE[character->type] &&
+        if (state->frame % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
+            rng_float(state, RNG_STREAM_AI, 0, 1) < ACTION_CHANCE[character->type] &&
             kinda_touching_ground &&
             character->action_timer <= ACTION_COOLDOWNS[character->type] &&
-            character->physx.y + character->physx.bb_height > 3 * 16) {
+            character->physx->y + character->physx->bb_height > 3 * 16) {
 
             character->wants_to_action = true;
             character->action_timer = ACTION_TELEGRAPH_TIMES[character->type];
@@ -1200,63 +2733,61 @@ InputProfile pre_process_ai(Character *character) {
 
         if (character->wants_to_action && character->action_timer <= 0) {
             if (character->type == CHARACTER_TYPE_X_SHOOTER)
-                shoot_x_bullet(character);
+                shoot_x_bullet(state, character);
             else if (character->type == CHARACTER_TYPE_Y_SHOOTER)
-                shoot_y_bullet(character);
+                shoot_y_bullet(state, character);
             else
-                shoot_xy_bullet(character);
+                shoot_xy_bullet(state, character);
             character->wants_to_action = false;
         }
     } else if (character->type == CHARACTER_TYPE_LASER) {
-        if (gFrameCounter % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
-            oct_Random(0, 1) < ACTION_CHANCE[character->type] &&
+        if (state->frame % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
+            rng_float(state, RNG_STREAM_AI, 0, 1) < ACTION_CHANCE[character->type] &&
             kinda_touching_ground &&
             character->action_timer <= ACTION_COOLDOWNS[character->type] &&
-            character->physx.y + character->physx.bb_height > 3 * 16) {
+            character->physx->y + character->physx->bb_height > 3 * 16) {
 
             character->wants_to_action = true;
             character->action_timer = ACTION_TELEGRAPH_TIMES[character->type];
         }
 
         if (character->wants_to_action && character->action_timer <= 0) {
-            imma_firin_muh_lazor(character);
+            imma_firin_muh_lazor(state, character);
             character->wants_to_action = false;
         }
     } else if (character->type == CHARACTER_TYPE_BOMBER) {
-        if (gFrameCounter % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
-            oct_Random(0, 1) < ACTION_CHANCE[character->type] &&
+        if (state->frame % ACTION_CHANCE_FREQUENCY[character->type] == 0 &&
+            rng_float(state, RNG_STREAM_AI, 0, 1) < ACTION_CHANCE[character->type] &&
             kinda_touching_ground &&
             character->action_timer <= ACTION_COOLDOWNS[character->type] &&
-            character->physx.y + character->physx.bb_height > 3 * 16) {
+            character->physx->y + character->physx->bb_height > 3 * 16) {
 
             character->wants_to_action = true;
             character->action_timer = ACTION_TELEGRAPH_TIMES[character->type];
         }
 
         if (character->wants_to_action && character->action_timer <= 0) {
-            blow_up(character);
-            kill_character(false, character, true);
+            blow_up(state, character);
+            kill_character(state, false, character, true);
         }
     } else if (character->type == CHARACTER_TYPE_DASHER) {
         // dasher is always pissed
         character->wants_to_action = true;
 
-        if (kinda_touching_ground) {
-            CollisionEvent left = collision_at(character, null, character->physx.x + character->physx.bb_width, character->physx.y, character->physx.bb_width, character->physx.bb_height);
-            CollisionEvent right = collision_at(character, null, character->physx.x - character->physx.bb_width, character->physx.y, character->physx.bb_width, character->physx.bb_height);
-            if (left.type == COLLISION_EVENT_TYPE_CHARACTER) {
-                left.character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-                character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-                character->physx.x_vel -= DASHER_FLING_X_DISTANCE;
-                kill_character(false, left.character, true);
-                oct_PlaySound(oct_GetAsset(gBundle, "sounds/punch.wav"), (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume}, false);
-            } else if (right.type == COLLISION_EVENT_TYPE_CHARACTER) {
-                right.character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-                character->physx.y_vel -= DASHER_FLING_Y_DISTANCE;
-                character->physx.x_vel += DASHER_FLING_X_DISTANCE;
-                kill_character(false, right.character, true);
-                oct_PlaySound(oct_GetAsset(gBundle, "sounds/punch.wav"), (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume}, false);
-            }
+        Character *right = character_get(state, character->contact.right);
+        Character *left = character_get(state, character->contact.left);
+        if (right) {
+            right->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+            character->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+            character->physx->x_vel -= DASHER_FLING_X_DISTANCE;
+            kill_character(state, false, right, true);
+            play_sound(state, gAssets[ASSET_SND_PUNCH], (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume}, false);
+        } else if (left) {
+            left->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+            character->physx->y_vel -= DASHER_FLING_Y_DISTANCE;
+            character->physx->x_vel += DASHER_FLING_X_DISTANCE;
+            kill_character(state, false, left, true);
+            play_sound(state, gAssets[ASSET_SND_PUNCH], (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume}, false);
         }
     }
 
@@ -1265,29 +2796,30 @@ InputProfile pre_process_ai(Character *character) {
     return input;
 }
 
-void process_character(Character *character) {
+void process_character(GameState *state, Character *character) {
     // This is only to handle input
     InputProfile input = {0};
+    update_contacts(state, character);
     if (character->player_controlled) {
-        input = process_player(character);
+        input = process_player(state, character);
     } else {
-        input = pre_process_ai(character);
+        input = pre_process_ai(state, character);
     }
 
     if (input.x_acc != 0) {
         character->facing = sign(input.x_acc);
     }
-    const bool x_coll = process_physics(character, null, &character->physx, input.x_acc, input.y_acc);
+    const bool x_coll = process_physics(state, character, null, character->physx, input.x_acc, input.y_acc);
 
     // Type specific stuff
     if (character->type == CHARACTER_TYPE_JUMPER) {
         // Jump on enemy head should kill them
-        const CollisionEvent y_collision = collision_at(character, null, character->physx.x - 5, character->physx.y + 3, character->physx.bb_width + 5, character->physx.bb_height);
+        const CollisionEvent y_collision = collision_at(state, character, null, character->physx->x - 5, character->physx->y + 3, character->physx->bb_width + 5, character->physx->bb_height);
         if (y_collision.type == COLLISION_EVENT_TYPE_CHARACTER) {
-            kill_character(character->player_controlled, y_collision.character, false);
+            kill_character(state, character->player_controlled, character_get(state, y_collision.character), false);
 
-            character->physx.y_vel -= PLAYER_JUMP_SPEED;
-            character->physx.x_vel = oct_Random(-ENEMY_FLING_SPEED, ENEMY_FLING_SPEED);
+            character->physx->y_vel -= PLAYER_JUMP_SPEED;
+            character->physx->x_vel = rng_float(state, RNG_STREAM_AI, -ENEMY_FLING_SPEED, ENEMY_FLING_SPEED);
         }
     }
 
@@ -1297,27 +2829,93 @@ void process_character(Character *character) {
             character->direction *= -1;
 
         // If they fall out the map they die :skull: -- player will handle their own deaths
-        if (character->physx.y > GAME_HEIGHT) {
-            character->alive = false;
+        if (character->physx->y > GAME_HEIGHT) {
+            release_character(state, character);
+        }
+    } else {
+        // player specific stuff
+    }
+
+    if (!gHeadless) draw_character(state, character);
+}
+
+// Same motion as process_physics gives a noclip object but friction only looks at the tile under
+// the particle. Only touches particle_bodies and reads the level so its safe on worker threads.
+// Dead slots in the range get integrated too, its cheaper than skipping them and they're
+// overwritten when the slot is reused.
+void particle_job(void *data) {
+    const ParticleJob *job = data;
+    GameState *state = job->state;
+    float *restrict x = &state->particle_bodies.x[job->start];
+    float *restrict y = &state->particle_bodies.y[job->start];
+    float *restrict x_vel = &state->particle_bodies.x_vel[job->start];
+    float *restrict y_vel = &state->particle_bodies.y_vel[job->start];
+    float drag[PARTICLE_JOB_SIZE];
+
+    // speed limit and friction, ground friction unless its ice. Dead particles can be anywhere so
+    // stay in floats until its known to be in bounds.
+    for (int i = 0; i < job->count; i++) {
+        x_vel[i] = oct_Clamp(-SPEED_LIMIT, SPEED_LIMIT, x_vel[i]);
+        y_vel[i] = oct_Clamp(-SPEED_LIMIT, SPEED_LIMIT, y_vel[i]);
+
+        const float column = floorf(x[i] / TILE_SIZE);
+        const float row = floorf((y[i] + 1) / TILE_SIZE);
+        uint8_t tile = 0;
+        if (column >= 0 && column < LEVEL_WIDTH && row >= 0 && row < LEVEL_HEIGHT)
+            tile = state->collision[((int32_t)row * LEVEL_WIDTH) + (int32_t)column];
+        drag[i] = !tile ? 1 - AIR_FRICTION : (tile & TILE_FLAG_ICE ? 1 : 1 - GROUND_FRICTION);
+    }
+
+    // branch free so it vectorizes
+    const int32_t count = job->count;
+    const float gravity = GRAVITY;
+    for (int i = 0; i < count; i++) {
+        x_vel[i] *= drag[i];
+        y_vel[i] += gravity;
+        x[i] += x_vel[i];
+        y[i] += y_vel[i];
+    }
+}
+
+// Splits the particle slots in use into jobs and waits on them. The engine's job system doesn't
+// exist without oct_Init so headless runs go through the same chunks on this thread.
+void integrate_particles(GameState *state, Oct_Allocator allocator) {
+    // slots are handed out lowest first so the live ones are packed near the start
+    const int32_t end = pool_end(&state->particle_pool);
+
+    for (int i = 0; i < end; i += PARTICLE_JOB_SIZE) {
+        ParticleJob job = {
+                .state = state,
+                .start = i,
+                .count = end - i < PARTICLE_JOB_SIZE ? end - i : PARTICLE_JOB_SIZE
+        };
+        if (gHeadless) {
+            particle_job(&job);
+        } else {
+            void *dest = oct_Malloc(allocator, sizeof(ParticleJob));
+            memcpy(dest, &job, sizeof(ParticleJob));
+            oct_QueueJob(particle_job, dest);
         }
-    } else {
-        // player specific stuff
     }
-
-    draw_character(character);
+    if (!gHeadless) oct_WaitJobs();
 }
 
-void process_particle(Particle *particle) {
-    process_physics(null, null, &particle->physx, 0, 0);
+// main thread only, draws the particle after its been integrated and ages it
+void process_particle(GameState *state, Particle *particle) {
+    const int32_t slot = particle - state->particles;
+    const float x = state->particle_bodies.x[slot];
+    const float y = state->particle_bodies.y[slot];
     const float percent = particle->lifetime / particle->total_lifetime;
 
     // draw
-    if (particle->sprite_based) {
+    if (gHeadless) {
+        // nothing to draw to
+    } else if (particle->sprite_based) {
         oct_DrawSpriteIntColourExt(
                 OCT_INTERPOLATE_ALL, particle->id,
                 particle->sprite, &particle->instance,
                 &(Oct_Colour){1, 1, 1, percent},
-                (Oct_Vec2){particle->physx.x, particle->physx.y},
+                (Oct_Vec2){x, y},
                 (Oct_Vec2){percent, percent},
                 0, (Oct_Vec2){0, 0});
     } else {
@@ -1325,85 +2923,58 @@ void process_particle(Particle *particle) {
                 OCT_INTERPOLATE_ALL, particle->id,
                 particle->texture,
                 &(Oct_Colour){1, 1, 1, percent},
-                (Oct_Vec2){particle->physx.x, particle->physx.y},
-                (Oct_Vec2){percent, percent},
+                (Oct_Vec2){x, y},
+                (Oct_Vec2){percent * particle->x_scale, percent},
                 0, (Oct_Vec2){0, 0});
     }
 
     // kill
     particle->lifetime -= 1.0/30.0;
     if (particle->lifetime <= 0) {
-        particle->alive = false;
-    }
-}
-
-/*
-void particle_job(void *data) {
-    ParticleJob *particle_job = data;
-
-    for (int i = particle_job->index; i < particle_job->count + particle_job->index; i++) {
-        if (!particle_job->list[i].alive) return;
-        process_particle(&particle_job->list[i]);
+        release_particle(state, particle);
     }
 }
 
-void queue_particles_jobs(Oct_Allocator allocator) {
-    const int particle_job_size = 25;
-    for (int i = 0; i < MAX_PARTICLES / particle_job_size; i++) {
-        ParticleJob job = {
-                .list = state.particles,
-                .index = i * particle_job_size,
-                .count = particle_job_size
-        };
-        void *dest = oct_Malloc(allocator, sizeof(ParticleJob));
-        memcpy(dest, &job, sizeof(ParticleJob));
-        oct_QueueJob(particle_job, dest);
-    }
-}*/
-
 /*
 void create_particles(CreateParticlesJob *job) {
     oct_QueueJob(create_particles_job, job);
 }*/
 
-void process_projectile(Projectile *projectile) {
-    process_physics(null, projectile, &projectile->physx, 0, 0);
+void process_projectile(GameState *state, Projectile *projectile) {
+    const float from_x = projectile->physx->x;
+    const float from_y = projectile->physx->y;
+    process_physics(state, null, projectile, projectile->physx, 0, 0);
 
-    // hit opps
-    CollisionEvent event = collision_at(
-            null, projectile,
-            projectile->physx.x,
-            projectile->physx.y,
-            projectile->physx.bb_width,
-            projectile->physx.bb_height);
+    // hit opps anywhere along the way
+    CollisionEvent event = sweep_projectile(state, projectile, from_x, from_y);
     if (event.type == COLLISION_EVENT_TYPE_CHARACTER) {
-        kill_character(projectile->player_bullet, event.character, false);
-        create_particles_job(&(CreateParticlesJob){
+        kill_character(state, projectile->player_bullet, character_get(state, event.character), false);
+        create_particles_job(state, &(CreateParticlesJob){
                 .variation = 1,
                 .y_vel = 0,
                 .x_vel = 0,
-                .tex = oct_GetAsset(gBundle, "textures/bullet.png"),
-                .spr = OCT_NO_ASSET,
-                .x = projectile->physx.x,
-                .y = projectile->physx.y,
+                .tex = ASSET_TEX_BULLET,
+                .spr = ASSET_NONE,
+                .x = projectile->physx->x,
+                .y = projectile->physx->y,
                 .count = 1,
                 .lifetime = 1
         });
-        projectile->alive = false;
+        release_projectile(state, projectile);
     }
 
     // lifetime
     projectile->lifetime -= 1.0 / 30.0;
     if (projectile->lifetime <= 0) {
-        projectile->alive = false;
-        create_particles_job(&(CreateParticlesJob){
+        release_projectile(state, projectile);
+        create_particles_job(state, &(CreateParticlesJob){
                 .variation = 1,
                 .y_vel = 0,
                 .x_vel = 0,
-                .tex = oct_GetAsset(gBundle, "textures/bullet.png"),
-                .spr = OCT_NO_ASSET,
-                .x = projectile->physx.x,
-                .y = projectile->physx.y,
+                .tex = ASSET_TEX_BULLET,
+                .spr = ASSET_NONE,
+                .x = projectile->physx->x,
+                .y = projectile->physx->y,
                 .count = 1,
                 .lifetime = 1
         });
@@ -1411,40 +2982,45 @@ void process_projectile(Projectile *projectile) {
     }
 
     // draw
-    oct_DrawTextureInt(
-            OCT_INTERPOLATE_ALL, projectile->id,
-            projectile->tex,
-            (Oct_Vec2){projectile->physx.x, projectile->physx.y}
-            );
+    if (!gHeadless) {
+        oct_DrawTextureInt(
+                OCT_INTERPOLATE_ALL, projectile->id,
+                projectile->tex,
+                (Oct_Vec2){projectile->physx->x, projectile->physx->y}
+                );
+    }
 }
 
-// copies a character into an available character slot and returns the character in the slot or
-// null if there was no available slot
-Character *add_character(Character *character) {
-    Character *slot = null;
-    for (int i = 0; i < MAX_CHARACTERS; i++) {
-        if (!state.characters[i].alive) {
-            slot = &state.characters[i];
-            memcpy(slot, character, sizeof(struct Character_t));
-            slot->alive = true;
-
-            // Handle sprite instance & bounding box
-            oct_InitSpriteInstance(&slot->sprite, character_type_sprite(slot), true);
-            slot->physx.bb_width = 12;
-            slot->physx.bb_height = 12;
-            slot->facing = 1;
-            slot->id = gParticleIDs;
-            gParticleIDs += 10;
+// copies a character into an available character slot at (x, y) and returns the character in the
+// slot or null if there was no available slot
+Character *add_character(GameState *state, Character *character, float x, float y) {
+    const int32_t spot = pool_alloc(&state->character_pool);
+    if (spot < 0) return null;
+
+    Character *slot = &state->characters[spot];
+    memcpy(slot, character, sizeof(struct Character_t));
+    slot->physx = &state->physics[spot];
+
+    // Handle sprite instance & bounding box
+    if (!gHeadless) oct_InitSpriteInstance(&slot->sprite, character_type_sprite(slot), true);
+    *slot->physx = (PhysicsObject){
+            .x = x,
+            .y = y,
+            .bb_width = 12,
+            .bb_height = 12,
+    };
+    slot->facing = 1;
+    slot->id = state->next_id;
+    state->next_id += 10;
+    partition_update(state, partition_object(state, slot, null));
+    contacts_late(state, partition_object(state, slot, null));
 
-            break;
-        }
-    }
     return slot;
 }
 
 // Adds an ai (higher level version of add_character)
-Character *add_ai(CharacterType type) {
-    const bool spawn_left = oct_Random(0, 1) > 0.5;
+Character *add_ai(GameState *state, CharacterType type) {
+    const bool spawn_left = rng_float(state, RNG_STREAM_SPAWN, 0, 1) > 0.5;
     float x_spawn;
     if (spawn_left) {
         x_spawn = 1.5 * 16;
@@ -1452,70 +3028,196 @@ Character *add_ai(CharacterType type) {
         x_spawn = 29.5 * 16;
     }
 
-    return add_character(&(Character){
+    return add_character(state, &(Character){
             .type = type,
-            .physx = {
-                    .x = x_spawn,
-                    .y = -16,
-            },
             .direction = spawn_left ? 1 : -1
-    });
+    }, x_spawn, -16);
 }
 
-Projectile *create_projectile(bool player_shot, Oct_Texture tex, float lifetime, float x, float y, float x_speed, float y_speed) {
-    Projectile *slot = null;
-    for (int i = 0; i < MAX_CHARACTERS; i++) {
-        if (!state.projectiles[i].alive) {
-            slot = &state.projectiles[i];
-            slot->alive = true;
-
-            slot->physx.bb_width = oct_TextureWidth(tex);
-            slot->physx.bb_height = oct_TextureHeight(tex);
-            slot->physx.x = x - (slot->physx.bb_width / 2);
-            slot->physx.y = y - (slot->physx.bb_height / 2);
-            slot->physx.x_vel = x_speed;
-            slot->physx.y_vel = y_speed;
-            slot->lifetime = lifetime;
-            slot->max_lifetime = lifetime;
-            slot->tex = tex;
-            slot->player_bullet = player_shot;
-            slot->id = gParticleIDs++;
-
-            // we wont make projectiles in spots where they are already colliding
-            const CollisionEvent event = collision_at(
-                    null,
-                    slot,
-                    slot->physx.x,
-                    slot->physx.y,
-                    slot->physx.bb_width,
-                    slot->physx.bb_height);
-            if (event.type == COLLISION_EVENT_TYPE_WALL || event.type == COLLISION_EVENT_TYPE_BOUNCY_WALL || event.type == COLLISION_EVENT_TYPE_PROJECTILE) {
-                slot->alive = false;
-                slot = null;
-            }
-
-            break;
-        }
+Projectile *create_projectile(GameState *state, bool player_shot, AssetID tex, float lifetime, float x, float y, float x_speed, float y_speed) {
+    const int32_t spot = pool_alloc(&state->projectile_pool);
+    if (spot < 0) return null;
+
+    Projectile *slot = &state->projectiles[spot];
+    slot->tex = asset_get(tex);
+    slot->tex_id = tex;
+    const float width = gHeadless ? HEADLESS_BULLET_WIDTH : oct_TextureWidth(slot->tex);
+    const float height = gHeadless ? HEADLESS_BULLET_HEIGHT : oct_TextureHeight(slot->tex);
+    *slot->physx = (PhysicsObject){
+            .x = x - (width / 2),
+            .y = y - (height / 2),
+            .x_vel = x_speed,
+            .y_vel = y_speed,
+            .bb_width = width,
+            .bb_height = height,
+    };
+    slot->lifetime = lifetime;
+    slot->max_lifetime = lifetime;
+    slot->player_bullet = player_shot;
+    slot->id = state->next_id++;
+    partition_update(state, partition_object(state, null, slot));
+    contacts_late(state, partition_object(state, null, slot));
+
+    // we wont make projectiles in spots where they are already colliding
+    const CollisionEvent event = collision_at(
+            state, null,
+            slot,
+            slot->physx->x,
+            slot->physx->y,
+            slot->physx->bb_width,
+            slot->physx->bb_height);
+    if (event.type == COLLISION_EVENT_TYPE_WALL || event.type == COLLISION_EVENT_TYPE_BOUNCY_WALL || event.type == COLLISION_EVENT_TYPE_PROJECTILE) {
+        release_projectile(state, slot);
+        slot = null;
     }
+
     return slot;
 }
 
+///////////////////////// PROFILER /////////////////////////
+// nanoseconds from a monotonic clock, unlike the wall clock it can't jump when the system time changes
+uint64_t clock_ns() {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    const uint64_t ticks = counter.QuadPart;
+    const uint64_t rate = frequency.QuadPart;
+    return ((ticks / rate) * 1000000000) + (((ticks % rate) * 1000000000) / rate);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+#endif
+}
+
+static inline void profile_begin(ProfilePhase phase) {
+    gProfiler.started[phase] = clock_ns();
+}
+
+// phases can be opened and closed several times a frame, it all adds up
+static inline void profile_end(ProfilePhase phase) {
+    gProfiler.current[phase] += clock_ns() - gProfiler.started[phase];
+}
+
+// every frame after this gets a row in the csv
+void profile_open_csv(const char *filename) {
+    gProfiler.csv = fopen(filename, "w");
+    if (!gProfiler.csv) {
+        oct_Raise(OCT_STATUS_ERROR, false, "couldn't open profiler csv %s", filename);
+        return;
+    }
+    fprintf(gProfiler.csv, "frame");
+    for (int i = 0; i < PROFILE_PHASE_MAX; i++)
+        fprintf(gProfiler.csv, ",%s_ns", PROFILE_PHASE_NAMES[i]);
+    fprintf(gProfiler.csv, "\n");
+}
+
+void profile_close_csv() {
+    if (gProfiler.csv)
+        fclose(gProfiler.csv);
+    gProfiler.csv = null;
+}
+
+// moves this frame's timings into the history (and csv)
+void profile_frame_end() {
+    if (gProfiler.csv) {
+        fprintf(gProfiler.csv, "%llu", (unsigned long long)gFrameCounter);
+        for (int i = 0; i < PROFILE_PHASE_MAX; i++)
+            fprintf(gProfiler.csv, ",%llu", (unsigned long long)gProfiler.current[i]);
+        fprintf(gProfiler.csv, "\n");
+    }
+
+    memcpy(gProfiler.history[gProfiler.head], gProfiler.current, sizeof(gProfiler.current));
+    memset(gProfiler.current, 0, sizeof(gProfiler.current));
+    gProfiler.head = (gProfiler.head + 1) % PROFILE_HISTORY;
+    if (gProfiler.count < PROFILE_HISTORY)
+        gProfiler.count++;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+ProfileStats profile_stats(ProfilePhase phase) {
+    ProfileStats stats = {0};
+    if (gProfiler.count == 0) return stats;
+
+    uint64_t sorted[PROFILE_HISTORY];
+    uint64_t total = 0;
+    for (int i = 0; i < gProfiler.count; i++) {
+        sorted[i] = gProfiler.history[i][phase];
+        total += sorted[i];
+    }
+    qsort(sorted, gProfiler.count, sizeof(uint64_t), compare_u64);
+
+    const int32_t p99 = (int32_t)ceil(gProfiler.count * 0.99) - 1;
+    stats.min = sorted[0] / 1e6;
+    stats.avg = (total / (double)gProfiler.count) / 1e6;
+    stats.p99 = sorted[p99] / 1e6;
+    return stats;
+}
+
+// drawn straight to the window so its readable at any scale
+void draw_profiler() {
+    if (!gProfiler.overlay) return;
+    const Oct_FontAtlas font = gAssets[ASSET_FNT_MONOGRAM];
+    const float line = 24;
+
+    oct_DrawRectangleColour(
+            &(Oct_Colour){0, 0, 0, 0.75},
+            &(Oct_Rectangle){
+                .position = {4, 4},
+                .size = {560, 12 + ((PROFILE_PHASE_MAX + 1) * line)}
+            },
+            true, 1);
+    oct_DrawText(font, (Oct_Vec2){10, 8}, 2, "%-12s %7s %7s %7s  (ms, %i frames)", "phase", "min", "avg", "p99", gProfiler.count);
+    for (int i = 0; i < PROFILE_PHASE_MAX; i++) {
+        const ProfileStats stats = profile_stats(i);
+        oct_DrawText(
+                font, (Oct_Vec2){10, 8 + ((i + 1) * line)}, 2,
+                "%-12s %7.3f %7.3f %7.3f", PROFILE_PHASE_NAMES[i], stats.min, stats.avg, stats.p99);
+    }
+}
+
 ///////////////////////// GAME /////////////////////////
-void game_begin() {
-    memset(&state, 0, sizeof(struct GameState_t));
-    state.level_map = oct_CreateTilemap(
-            oct_GetAsset(gBundle, "textures/tileset.png"),
-            LEVEL_WIDTH, LEVEL_HEIGHT,
-            (Oct_Vec2){16, 16});
-    state.req_kills = START_REQ_KILLS;
-    oct_InitSpriteInstance(&state.fire, oct_GetAsset(gBundle, "sprites/fire.json"), true);
-    state.player_transform_time = -5;
-    state.outta_time = UINT64_MAX;
+// Starts a fresh game on map as body. Input comes from replay if its playing one back, otherwise
+// from the devices (nobody in headless games), and gets recorded into it if its recording. replay
+// can be null.
+void game_begin(GameState *state, StartingMap map, StartingBody body, uint64_t seed, Replay *replay) {
+    memset(state, 0, sizeof(struct GameState_t));
+    state->map = map;
+    state->body = body;
+    state->replay = replay;
+    state->next_id = FIRST_ENTITY_ID;
+    for (int i = 0; i < MAX_CHARACTERS; i++)
+        state->characters[i].physx = &state->physics[i];
+    for (int i = 0; i < MAX_PROJECTILES; i++)
+        state->projectiles[i].physx = &state->physics[MAX_CHARACTERS + i];
+    state->seed = seed;
+    for (int i = 0; i < RNG_STREAM_MAX; i++)
+        rng_seed(&state->rng[i], seed, i);
+    partition_clear(state);
+    pool_init(&state->character_pool, MAX_CHARACTERS);
+    pool_init(&state->projectile_pool, MAX_PROJECTILES);
+    pool_init(&state->particle_pool, MAX_PARTICLES);
+    if (!gHeadless) {
+        state->level_map = oct_CreateTilemap(
+                gAssets[ASSET_TEX_TILESET],
+                LEVEL_WIDTH, LEVEL_HEIGHT,
+                (Oct_Vec2){TILE_SIZE, TILE_SIZE});
+        oct_InitSpriteInstance(&state->fire, gAssets[ASSET_SPR_FIRE], true);
+    }
+    state->req_kills = START_REQ_KILLS;
+    state->player_transform_time = -5;
+    state->outta_time = UINT64_MAX;
 
     // Open json with level
     const char *maps[] = {"map1.tmj", "map2.tmj", "map3.tmj"};
     uint32_t size;
-    uint8_t *data = oct_ReadFile(maps[menu_state.map], gAllocator, &size);
+    uint8_t *data = oct_ReadFile(maps[state->map], gAllocator, &size);
     cJSON *json = cJSON_ParseWithLength((void *)data, size);
     if (!data || !json)
         oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, true, "no level file womp womp");
@@ -1533,39 +3235,39 @@ void game_begin() {
     for (int y = 0; y < LEVEL_HEIGHT; y++) {
         for (int x = 0; x < LEVEL_WIDTH; x++) {
             int32_t item = (int)cJSON_GetNumberValue(cJSON_GetArrayItem(level_data, (y * LEVEL_WIDTH) + x));
-            oct_SetTilemap(state.level_map, x, y, item);
+            state->collision[(y * LEVEL_WIDTH) + x] = item >= 0 && item < TILE_FLAGS_SIZE ? TILE_FLAGS[item] : TILE_FLAG_SOLID;
+            if (!gHeadless) oct_SetTilemap(state->level_map, x, y, item);
         }
     }
     cJSON_Delete(json);
 
-    Save s = parse_save();
-    state.in_tutorial = !s.has_done_tutorial;
-    s.has_done_tutorial = true;
-    save_game(&s);
+    // headless runs skip the tutorial and never touch the save
+    if (!gHeadless) {
+        Save s = parse_save();
+        state->in_tutorial = !s.has_done_tutorial;
+        s.has_done_tutorial = true;
+        save_game(&s);
+    }
+    if (replay && replay->mode == REPLAY_MODE_PLAYING)
+        state->in_tutorial = replay->tutorial;
+    else if (replay && replay->mode == REPLAY_MODE_RECORDING)
+        replay_start_recording(state);
 
     // Add the player
-    state.player = add_character(&(Character){
-        .type = menu_state.character == STARTING_BODY_JUMPER ? CHARACTER_TYPE_JUMPER : CHARACTER_TYPE_Y_SHOOTER,
+    state->player = character_handle(state, add_character(state, &(Character){
+        .type = state->body == STARTING_BODY_JUMPER ? CHARACTER_TYPE_JUMPER : CHARACTER_TYPE_Y_SHOOTER,
         .player_controlled = true,
-        .physx = {
-                .x = 15.5 * 16,
-                .y = 11 * 16,
-        }
-    });
-    state.lifespan = PLAYER_STARTING_LIFESPAN;
-    state.max_lifespan = PLAYER_STARTING_LIFESPAN;
-    state.fade_in = FADE_IN_OUT_TIME;
-
-    // play game music
-    oct_StopSound(gPlayingMusic);
-    if (oct_Random(0, 1) > 0.5) {
-        gPlayingMusic = oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/ost1.ogg"),
-                (Oct_Vec2){GLOBAL_MUSIC_VOLUME * gMusicVolume, GLOBAL_MUSIC_VOLUME * gMusicVolume},
-                true);
-    } else {
-        gPlayingMusic = oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/ost2.ogg"),
+    }, 15.5 * 16, 11 * 16));
+    state->lifespan = PLAYER_STARTING_LIFESPAN;
+    state->max_lifespan = PLAYER_STARTING_LIFESPAN;
+    state->fade_in = FADE_IN_OUT_TIME;
+
+    // play game music, the music is the one thing games share so headless ones leave it alone
+    const Oct_Asset music = rng_float(state, RNG_STREAM_COSMETIC, 0, 1) > 0.5 ? gAssets[ASSET_SND_OST1] : gAssets[ASSET_SND_OST2];
+    if (!gHeadless) {
+        oct_StopSound(gPlayingMusic);
+        gPlayingMusic = play_sound(
+                state, music,
                 (Oct_Vec2){GLOBAL_MUSIC_VOLUME * gMusicVolume, GLOBAL_MUSIC_VOLUME * gMusicVolume},
                 true);
     }
@@ -1612,15 +3314,16 @@ void draw_text_box(float x, float y, const char *txt) {
             true, 1);
     oct_DrawTextInt(
             OCT_INTERPOLATE_ALL, 90,
-            oct_GetAsset(gBundle, "fnt_monogram"),
+            gAssets[ASSET_FNT_MONOGRAM],
             (Oct_Vec2){roundf(x - (size_x / 2)), roundf(y - (size_y / 2))},
             1,
             "%s", txt);
 }
 
-void handle_tutorial() {
-    if (!state.in_tutorial) return;
-    if (state.total_time >= 45) state.in_tutorial = false;
+void handle_tutorial(GameState *state) {
+    if (!state->in_tutorial) return;
+    if (state->total_time >= 45) state->in_tutorial = false;
+    if (gHeadless) return;
 
     /*
      * order is as follows:
@@ -1631,62 +3334,62 @@ void handle_tutorial() {
      *  - stay alive
      * */
 
-    if (state.total_time < 10) {
+    if (state->total_time < 10) {
         draw_text_box(GAME_WIDTH / 2, GAME_HEIGHT / 2, "Welcome to the game!\nTake some time to learn the controls.");
-    } else if (state.total_time < 20) {
+    } else if (state->total_time < 20) {
         draw_text_box(GAME_WIDTH / 2, GAME_HEIGHT / 2, "Press arrow keys to move\nand space to use your action.\nYour action depends on the body\nyou inhabit.");
-    } else if (state.total_time < 30) {
+    } else if (state->total_time < 30) {
         draw_text_box(GAME_WIDTH / 2, 64, "You will die when this time runs out.\nTake over bodies to get more time.");
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, 8,
-                oct_GetAsset(gBundle, "textures/pointer.png"),
+                gAssets[ASSET_TEX_POINTER],
                 (Oct_Vec2){160 + (sin(oct_Time() * 2) * 10), 24});
-    } else if (state.total_time < 40) {
+    } else if (state->total_time < 40) {
         draw_text_box(GAME_WIDTH / 2, 100, "Take over bodies by filling up\nthis kill gauge.");
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, 8,
-                oct_GetAsset(gBundle, "textures/pointer.png"),
+                gAssets[ASSET_TEX_POINTER],
                 (Oct_Vec2){155 + (sin(oct_Time() * 2) * 10), 58});
-    } else if (state.total_time < 45) {
+    } else if (state->total_time < 45) {
         draw_text_box(GAME_WIDTH / 2, GAME_HEIGHT / 2, "Watch out for the bouncy\nwalls and have fun!");
     }
 }
 
-void draw_time_bar() {
-    const float percent = oct_Clamp(0, 1, state.lifespan / state.max_lifespan);
+void draw_time_bar(GameState *state) {
+    const float percent = oct_Clamp(0, 1, state->lifespan / state->max_lifespan);
     const float clock_x = 232;
     const float clock_y = 17 - 3;
     const float clock_hand_x = 255;
     const float clock_hand_y = 40 - 3;
 
-    if (state.player_iframes > 0) {
+    if (state->player_iframes > 0) {
         oct_DrawTextureColour(
-                oct_GetAsset(gBundle, "textures/clock.png"),
+                gAssets[ASSET_TEX_CLOCK],
                 &(Oct_Colour){1, 0.5, 0.5, 1},
                 (Oct_Vec2){clock_x, clock_y}
         );
     } else {
         oct_DrawTexture(
-                oct_GetAsset(gBundle, "textures/clock.png"),
+                gAssets[ASSET_TEX_CLOCK],
                 (Oct_Vec2){clock_x, clock_y}
         );
     }
 
-    state.shown_clock_percent += (percent - state.shown_clock_percent) * 0.3;
+    state->shown_clock_percent += (percent - state->shown_clock_percent) * 0.3;
     oct_DrawTextureIntExt(
             OCT_INTERPOLATE_ALL, 420,
-            oct_GetAsset(gBundle, "textures/clockhand.png"),
+            gAssets[ASSET_TEX_CLOCKHAND],
             (Oct_Vec2){clock_hand_x, clock_hand_y},
             (Oct_Vec2){1, 1},
-            -state.shown_clock_percent * M_PI * 2,
+            -state->shown_clock_percent * M_PI * 2,
             (Oct_Vec2){OCT_ORIGIN_MIDDLE, OCT_ORIGIN_MIDDLE});
 }
 
-void draw_score() {
-    const Oct_FontAtlas kingdom = oct_GetAsset(gBundle, "fnt_kingdom");
+void draw_score(GameState *state) {
+    const Oct_FontAtlas kingdom = gAssets[ASSET_FNT_KINGDOM];
     const float y = 2;
     // If user is 1 kill away from transforming, tell them
-    if (state.req_kills -1 == state.current_kills && !state.player_died) {
+    if (state->req_kills -1 == state->current_kills && !state->player_died) {
         Oct_Vec2 text_size;
         const float scale = (sin(oct_Time() * 4) / 4) + 1;
         oct_GetTextSize(kingdom, text_size, scale, "Transform!");
@@ -1694,54 +3397,54 @@ void draw_score() {
                            &(Oct_Colour) {0, 0, 0, 1}, scale, "Transform!");
         oct_DrawText(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (text_size[0] / 2), y}, scale, "Transform!");
     } else {
-        if (state.player_died && state.got_highscore) {
+        if (state->player_died && state->got_highscore) {
             const float scale = (sin(oct_Time() * 4) / 4) + 1;
             Oct_Vec2 text_size;
-            oct_GetTextSize(kingdom, text_size, scale, "Score: %i", (int)state.score);
+            oct_GetTextSize(kingdom, text_size, scale, "Score: %i", (int)state->score);
             oct_DrawTextColour(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (text_size[0] / 2) + 1, y},
-                               &(Oct_Colour) {0, 0, 0, 1}, scale, "Score: %i", (int)state.score);
-            oct_DrawText(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (text_size[0] / 2), y}, scale, "Score: %i", (int)state.score);
+                               &(Oct_Colour) {0, 0, 0, 1}, scale, "Score: %i", (int)state->score);
+            oct_DrawText(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (text_size[0] / 2), y}, scale, "Score: %i", (int)state->score);
         } else {
             Oct_Vec2 size;
-            oct_GetTextSize(kingdom, size, 1, "Score: %i", (int)state.score);
+            oct_GetTextSize(kingdom, size, 1, "Score: %i", (int)state->score);
             oct_DrawTextColour(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (size[0] / 2) + 1, y}, &(Oct_Colour) {0, 0, 0, 1},
-                               1, "Score: %i", (int)state.score);
-            oct_DrawText(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (size[0] / 2), y}, 1, "Score: %i", (int)state.score);
+                               1, "Score: %i", (int)state->score);
+            oct_DrawText(kingdom, (Oct_Vec2) {(GAME_WIDTH / 2) - (size[0] / 2), y}, 1, "Score: %i", (int)state->score);
         }
     }
 }
 
-void draw_time_alert() {
+void draw_time_alert(GameState *state) {
     // 160,80
     const float x = (GAME_WIDTH / 2);
     const float y = (GAME_HEIGHT / 2);
 
-    if (state.lifespan < 5 && !state.player_died) {
-        if (state.outta_time == UINT64_MAX) {
-            state.outta_time = oct_PlaySound(oct_GetAsset(gBundle, "sounds/outtatime.wav"), (Oct_Vec2){gSoundVolume, gSoundVolume}, false);
+    if (state->lifespan < 5 && !state->player_died) {
+        if (state->outta_time == UINT64_MAX) {
+            state->outta_time = play_sound(state, gAssets[ASSET_SND_OUTTATIME], (Oct_Vec2){gSoundVolume, gSoundVolume}, false);
         }
 
         const float scale = (sin(oct_Time() * 2) + 1.8) * 0.3;
         const float rotation = cos(oct_Time() * 2.5) * 0.3;
         oct_DrawTextureIntExt(
                 OCT_INTERPOLATE_ALL, 7,
-                oct_GetAsset(gBundle, "textures/danger.png"),
+                gAssets[ASSET_TEX_DANGER],
                 (Oct_Vec2){x, y},
                 (Oct_Vec2){scale, scale},
                 rotation, (Oct_Vec2){OCT_ORIGIN_MIDDLE, OCT_ORIGIN_MIDDLE});
-    } else if (state.outta_time != UINT64_MAX) {
-        oct_StopSound(state.outta_time);
-        state.outta_time = UINT64_MAX;
+    } else if (state->outta_time != UINT64_MAX) {
+        oct_StopSound(state->outta_time);
+        state->outta_time = UINT64_MAX;
     }
 }
 
-void draw_kill_bar() {
-    const float percent_kills = oct_Clamp(0, 1, (state.displayed_kills / ((float)state.req_kills - 1)));
-    state.displayed_kills += (state.current_kills - state.displayed_kills) * 0.5;
+void draw_kill_bar(GameState *state) {
+    const float percent_kills = oct_Clamp(0, 1, (state->displayed_kills / ((float)state->req_kills - 1)));
+    state->displayed_kills += (state->current_kills - state->displayed_kills) * 0.5;
     const float x2 = 210;
     const float y2 = 56;
     oct_DrawTexture(
-            oct_GetAsset(gBundle, "textures/killcountempty.png"),
+            gAssets[ASSET_TEX_KILLCOUNTEMPTY],
             (Oct_Vec2){x2, y2}
     );
     Oct_DrawCommand cmd2 = {
@@ -1750,7 +3453,7 @@ void draw_kill_bar() {
             .id = 42069,
             .colour = {1, 1, 1, 1},
             .Texture = {
-                    .texture = oct_GetAsset(gBundle, "textures/killcount.png"),
+                    .texture = gAssets[ASSET_TEX_KILLCOUNT],
                     .viewport = (Oct_Rectangle){
                             .position = {0, 0},
                             .size = {92 * percent_kills, 16},
@@ -1764,27 +3467,27 @@ void draw_kill_bar() {
     oct_Draw(&cmd2);
 }
 
-int32_t same_chance(int32_t n){
-    return (int32_t)floorf(oct_Random(0, n));
+int32_t same_chance(GameState *state, int32_t n){
+    return (int32_t)floorf(rng_float(state, RNG_STREAM_SPAWN, 0, n));
 }
 
-void handle_enemy_spawns1() {
-    state.frame_count++;
-    if (state.game_phase < GAME_PHASES - 1 && state.frame_count >= TIME_BETWEEN_PHASES[state.game_phase] && !state.player_died) {
-        state.game_phase += 1;
-        state.frame_count = 0;
+void handle_enemy_spawns1(GameState *state) {
+    state->frame_count++;
+    if (state->game_phase < GAME_PHASES - 1 && state->frame_count >= TIME_BETWEEN_PHASES[state->game_phase] && !state->player_died) {
+        state->game_phase += 1;
+        state->frame_count = 0;
     }
 
-    if (gFrameCounter % SPAWN_FREQUENCIES[state.game_phase] == 0) {
-        if (state.game_phase == 0) {
+    if (state->frame % SPAWN_FREQUENCIES[state->game_phase] == 0) {
+        if (state->game_phase == 0) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_Y_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 1) {
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 1) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_JUMPER,
@@ -1792,9 +3495,9 @@ void handle_enemy_spawns1() {
                     CHARACTER_TYPE_Y_SHOOTER,
                     CHARACTER_TYPE_X_SHOOTER
             };
-            const int32_t opp = same_chance(5);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 2) {
+            const int32_t opp = same_chance(state, 5);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 2) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_XY_SHOOTER,
                     CHARACTER_TYPE_Y_SHOOTER,
@@ -1802,17 +3505,17 @@ void handle_enemy_spawns1() {
                     CHARACTER_TYPE_X_SHOOTER,
                     CHARACTER_TYPE_X_SHOOTER
             };
-            const int32_t opp = same_chance(5);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 3) {
+            const int32_t opp = same_chance(state, 5);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 3) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_XY_SHOOTER,
                     CHARACTER_TYPE_XY_SHOOTER,
                     CHARACTER_TYPE_JUMPER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 4) {
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 4) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_JUMPER,
@@ -1821,23 +3524,23 @@ void handle_enemy_spawns1() {
                     CHARACTER_TYPE_LASER,
                     CHARACTER_TYPE_DASHER
             };
-            const int32_t opp = same_chance(6);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 5) {
+            const int32_t opp = same_chance(state, 6);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 5) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_DASHER
             };
-            const int32_t opp = same_chance(1);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 6) {
+            const int32_t opp = same_chance(state, 1);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 6) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_LASER,
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_Y_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 7) {
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 7) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_X_SHOOTER,
@@ -1848,74 +3551,74 @@ void handle_enemy_spawns1() {
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_BOMBER,
             };
-            const int32_t opp = same_chance(8);
-            add_ai(opps[opp]);
+            const int32_t opp = same_chance(state, 8);
+            add_ai(state, opps[opp]);
         }
     }
 }
-void handle_enemy_spawns2() {
-    state.frame_count++;
-    if (state.game_phase < GAME_PHASES - 1 && state.frame_count >= TIME_BETWEEN_PHASES2[state.game_phase] && !state.player_died) {
-        state.game_phase += 1;
-        state.frame_count = 0;
+void handle_enemy_spawns2(GameState *state) {
+    state->frame_count++;
+    if (state->game_phase < GAME_PHASES - 1 && state->frame_count >= TIME_BETWEEN_PHASES2[state->game_phase] && !state->player_died) {
+        state->game_phase += 1;
+        state->frame_count = 0;
     }
 
-    if (gFrameCounter % SPAWN_FREQUENCIES[state.game_phase] == 0) {
-        if (state.game_phase == 0) {
+    if (state->frame % SPAWN_FREQUENCIES[state->game_phase] == 0) {
+        if (state->game_phase == 0) {
             const int32_t opps[] = { // j y y
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_Y_SHOOTER,
                     CHARACTER_TYPE_Y_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 1) { // j x y
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 1) { // j x y
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_Y_SHOOTER,
                     CHARACTER_TYPE_X_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 2) { // xy y
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 2) { // xy y
             const int32_t opps[] = {
                     CHARACTER_TYPE_XY_SHOOTER,
                     CHARACTER_TYPE_Y_SHOOTER,
             };
-            const int32_t opp = same_chance(2);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 3) { // d l xy
+            const int32_t opp = same_chance(state, 2);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 3) { // d l xy
             const int32_t opps[] = {
                     CHARACTER_TYPE_DASHER,
                     CHARACTER_TYPE_LASER,
                     CHARACTER_TYPE_XY_SHOOTER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 4) { // l l x
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 4) { // l l x
             const int32_t opps[] = {
                     CHARACTER_TYPE_X_SHOOTER,
                     CHARACTER_TYPE_LASER,
                     CHARACTER_TYPE_LASER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 5) { // y b b
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 5) { // y b b
             const int32_t opps[] = {
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_Y_SHOOTER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 6) { // b d
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 6) { // b d
             const int32_t opps[] = {
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_DASHER,
             };
-            const int32_t opp = same_chance(2);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 7) {
+            const int32_t opp = same_chance(state, 2);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 7) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_X_SHOOTER,
@@ -1926,74 +3629,74 @@ void handle_enemy_spawns2() {
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_BOMBER,
             };
-            const int32_t opp = same_chance(8);
-            add_ai(opps[opp]);
+            const int32_t opp = same_chance(state, 8);
+            add_ai(state, opps[opp]);
         }
     }
 }
-void handle_enemy_spawns3() {
-    state.frame_count++;
-    if (state.game_phase < GAME_PHASES - 1 && state.frame_count >= TIME_BETWEEN_PHASES3[state.game_phase] && !state.player_died) {
-        state.game_phase += 1;
-        state.frame_count = 0;
+void handle_enemy_spawns3(GameState *state) {
+    state->frame_count++;
+    if (state->game_phase < GAME_PHASES - 1 && state->frame_count >= TIME_BETWEEN_PHASES3[state->game_phase] && !state->player_died) {
+        state->game_phase += 1;
+        state->frame_count = 0;
     }
 
-    if (gFrameCounter % SPAWN_FREQUENCIES[state.game_phase] == 0) {
-        if (state.game_phase == 0) {
+    if (state->frame % SPAWN_FREQUENCIES[state->game_phase] == 0) {
+        if (state->game_phase == 0) {
             const int32_t opps[] = { // xy y j
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_XY_SHOOTER,
                     CHARACTER_TYPE_Y_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 1) { // x xy j
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 1) { // x xy j
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_X_SHOOTER,
                     CHARACTER_TYPE_XY_SHOOTER
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 2) { // j j l
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 2) { // j j l
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_LASER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 3) { // d x x
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 3) { // d x x
             const int32_t opps[] = {
                     CHARACTER_TYPE_X_SHOOTER,
                     CHARACTER_TYPE_X_SHOOTER,
                     CHARACTER_TYPE_DASHER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 4) { // l d d
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 4) { // l d d
             const int32_t opps[] = {
                     CHARACTER_TYPE_LASER,
                     CHARACTER_TYPE_DASHER,
                     CHARACTER_TYPE_DASHER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 5) { // j d l
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 5) { // j d l
             const int32_t opps[] = {
                     CHARACTER_TYPE_DASHER,
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_LASER,
             };
-            const int32_t opp = same_chance(3);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 6) { // b
+            const int32_t opp = same_chance(state, 3);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 6) { // b
             const int32_t opps[] = {
                     CHARACTER_TYPE_BOMBER,
             };
-            const int32_t opp = same_chance(1);
-            add_ai(opps[opp]);
-        } else if (state.game_phase == 7) {
+            const int32_t opp = same_chance(state, 1);
+            add_ai(state, opps[opp]);
+        } else if (state->game_phase == 7) {
             const int32_t opps[] = {
                     CHARACTER_TYPE_JUMPER,
                     CHARACTER_TYPE_X_SHOOTER,
@@ -2004,55 +3707,55 @@ void handle_enemy_spawns3() {
                     CHARACTER_TYPE_BOMBER,
                     CHARACTER_TYPE_BOMBER,
             };
-            const int32_t opp = same_chance(8);
-            add_ai(opps[opp]);
+            const int32_t opp = same_chance(state, 8);
+            add_ai(state, opps[opp]);
         }
     }
 }
 
-void draw_player_death_screen() {
-    if (state.player_died) {
+void draw_player_death_screen(GameState *state) {
+    if (state->player_died) {
         const float banner_drop_time = 2; // seconds
-        const float drop_percent = 1 - oct_Clamp(0, 1, -pow(((state.total_time - state.player_die_time) / banner_drop_time), 2) + 1);
+        const float drop_percent = 1 - oct_Clamp(0, 1, -pow(((state->total_time - state->player_die_time) / banner_drop_time), 2) + 1);
         const float target_x = (GAME_WIDTH / 2);
         const float target_y = (GAME_HEIGHT / 2);
         const float real_y = target_y * drop_percent;
 
         // a bunch of effects when the banner hits the bottom
-        if (drop_percent >= 1 && !state.banner_dropped) {
-            state.banner_dropped = true;
-            oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/bumpwall.wav"),
+        if (drop_percent >= 1 && !state->banner_dropped) {
+            state->banner_dropped = true;
+            play_sound(
+                    state, gAssets[ASSET_SND_BUMPWALL],
                     (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
                     false);
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                     .variation = 3,
                     .y_vel = -4,
                     .x_vel = 0,
-                    .tex = oct_GetAsset(gBundle, "textures/garbageparticle.png"),
-                    .spr = OCT_NO_ASSET,
+                    .tex = ASSET_TEX_GARBAGEPARTICLE,
+                    .spr = ASSET_NONE,
                     .x = (GAME_WIDTH / 2) - 64,
                     .y = (GAME_HEIGHT / 2) + 24,
                     .count = 20,
                     .lifetime = 1
             });
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                     .variation = 3,
                     .y_vel = -4,
                     .x_vel = 0,
-                    .tex = oct_GetAsset(gBundle, "textures/garbageparticle.png"),
-                    .spr = OCT_NO_ASSET,
+                    .tex = ASSET_TEX_GARBAGEPARTICLE,
+                    .spr = ASSET_NONE,
                     .x = (GAME_WIDTH / 2),
                     .y = (GAME_HEIGHT / 2) + 24,
                     .count = 20,
                     .lifetime = 1
             });
-            create_particles_job(&(CreateParticlesJob){
+            create_particles_job(state, &(CreateParticlesJob){
                     .variation = 3,
                     .y_vel = -4,
                     .x_vel = 0,
-                    .tex = oct_GetAsset(gBundle, "textures/garbageparticle.png"),
-                    .spr = OCT_NO_ASSET,
+                    .tex = ASSET_TEX_GARBAGEPARTICLE,
+                    .spr = ASSET_NONE,
                     .x = (GAME_WIDTH / 2) + 64,
                     .y = (GAME_HEIGHT / 2) + 24,
                     .count = 20,
@@ -2060,23 +3763,25 @@ void draw_player_death_screen() {
             });
         }
 
+        if (gHeadless) return;
         oct_DrawTextureIntExt(
                 OCT_INTERPOLATE_ALL, 21,
-                state.got_highscore ? oct_GetAsset(gBundle, "textures/highscore.png") : oct_GetAsset(gBundle, "textures/itsover.png"),
+                state->got_highscore ? gAssets[ASSET_TEX_HIGHSCORE] : gAssets[ASSET_TEX_ITSOVER],
                 (Oct_Vec2){target_x, real_y},
                 (Oct_Vec2){drop_percent, drop_percent},
                 0, (Oct_Vec2){OCT_ORIGIN_MIDDLE, OCT_ORIGIN_MIDDLE});
     }
 }
 
-void draw_transform_indicator() {
-    if (state.total_time - state.player_transform_time < TRANSFORM_INDICATE_TIME) {
-        const float percent = (state.total_time - state.player_transform_time) / TRANSFORM_INDICATE_TIME;
+void draw_transform_indicator(GameState *state) {
+    const Character *player = character_get(state, state->player);
+    if (player && state->total_time - state->player_transform_time < TRANSFORM_INDICATE_TIME) {
+        const float percent = (state->total_time - state->player_transform_time) / TRANSFORM_INDICATE_TIME;
         oct_DrawCircleIntColour(
                 OCT_INTERPOLATE_ALL,
                 55,
                 &(Oct_Circle){
-                    .position = {state.player->physx.x + 6, state.player->physx.y + 6},
+                    .position = {player->physx->x + 6, player->physx->y + 6},
                     .radius = percent * 60,
                 },
                 &(Oct_Colour){1, 1, 1, oct_Sirp(1, 0, percent)},
@@ -2084,127 +3789,144 @@ void draw_transform_indicator() {
     }
 }
 
-GameStatus game_update() {
-    Oct_Texture texs[] = {
-            oct_GetAsset(gBundle, "textures/bg1.png"),
-            oct_GetAsset(gBundle, "textures/bg2.png"),
-            oct_GetAsset(gBundle, "textures/bg3.png")
-    };
-    oct_DrawTexture(texs[menu_state.map], (Oct_Vec2){0, 0});
+GameStatus game_update(GameState *state) {
+    if (state->replay)
+        replay_between_frames(state);
+    state->frame++;
+    state->input = poll_input(state);
+
+    if (!gHeadless) {
+        Oct_Texture texs[] = {
+                gAssets[ASSET_TEX_BG1],
+                gAssets[ASSET_TEX_BG2],
+                gAssets[ASSET_TEX_BG3]
+        };
+        oct_DrawTexture(texs[state->map], (Oct_Vec2){0, 0});
 
-    oct_TilemapDraw(state.level_map);
+        oct_TilemapDraw(state->level_map);
+    }
 
     // DEBUG
-    if (oct_KeyPressed(OCT_KEY_Q))
-        add_ai(CHARACTER_TYPE_DASHER);
-    if (oct_KeyPressed(OCT_KEY_E))
-        add_ai(CHARACTER_TYPE_LASER);
-    if (oct_KeyPressed(OCT_KEY_R))
-        add_ai(CHARACTER_TYPE_BOMBER);
-
-    // this is causing major fuckups that im not dealing with
-    //queue_particles_jobs(gFrameAllocator);
-    draw_kill_bar();
-    draw_time_bar();
-    draw_score();
-
-    for (int i = 0; i < MAX_CHARACTERS; i++) {
-        if (!state.characters[i].alive) continue;
-        process_character(&state.characters[i]);
+    if (state->input.buttons & INPUT_SPAWN_DASHER)
+        add_ai(state, CHARACTER_TYPE_DASHER);
+    if (state->input.buttons & INPUT_SPAWN_LASER)
+        add_ai(state, CHARACTER_TYPE_LASER);
+    if (state->input.buttons & INPUT_SPAWN_BOMBER)
+        add_ai(state, CHARACTER_TYPE_BOMBER);
+
+    if (!gHeadless) {
+        profile_begin(PROFILE_PHASE_HUD);
+        draw_kill_bar(state);
+        draw_time_bar(state);
+        draw_score(state);
+        profile_end(PROFILE_PHASE_HUD);
     }
 
+    // slot order, not spawn order (see EntityPool), and anything spawned past the slot being
+    // processed gets processed this frame too
+    profile_begin(PROFILE_PHASE_CHARACTERS);
+    contacts_build(state);
+    const EntityPool *characters = &state->character_pool;
+    for (int32_t i = pool_next(characters, 0); i != -1; i = pool_next(characters, i + 1))
+        process_character(state, &state->characters[i]);
+    profile_end(PROFILE_PHASE_CHARACTERS);
+
     // TODO: Put this shit in a job cuz idgaf about race conditions
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!state.projectiles[i].alive) continue;
-        process_projectile(&state.projectiles[i]);
+    profile_begin(PROFILE_PHASE_PROJECTILES);
+    const EntityPool *projectiles = &state->projectile_pool;
+    for (int32_t i = pool_next(projectiles, 0); i != -1; i = pool_next(projectiles, i + 1))
+        process_projectile(state, &state->projectiles[i]);
+    profile_end(PROFILE_PHASE_PROJECTILES);
+
+    draw_player_death_screen(state);
+    if (!gHeadless) {
+        draw_transform_indicator(state);
+        draw_time_alert(state);
     }
-
-    draw_player_death_screen();
-    draw_transform_indicator();
-    draw_time_alert();
-    handle_tutorial();
+    handle_tutorial(state);
 
     // things that only happen if no tutorial
-    state.total_time += 1.0 / 30.0;
-    if (!state.in_tutorial) {
+    state->total_time += 1.0 / 30.0;
+    if (!state->in_tutorial) {
         // player :skull: if out of time
-        state.lifespan -= 1.0 / 30.0;
-        if (state.lifespan <= 0 && !state.player_died) {
-            kill_character(false, state.player, false);
+        state->lifespan -= 1.0 / 30.0;
+        Character *player = character_get(state, state->player);
+        if (state->lifespan <= 0 && !state->player_died && player) {
+            kill_character(state, false, player, false);
         }
 
-        if (!state.player_died) {
-            const float prev_score = state.score;
-            state.score += 1 + state.game_phase;
+        if (!state->player_died) {
+            const float prev_score = state->score;
+            state->score += 1 + state->game_phase;
 
             // show little animations for getting scores
-            if (state.score >= 5000 && prev_score < 5000) {
-                create_particles_job(&(CreateParticlesJob){
+            if (state->score >= 5000 && prev_score < 5000) {
+                create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/5kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_5KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
                         .lifetime = 4
                 });
-            } else if (state.score >= 10000 && prev_score < 10000) {
-                    create_particles_job(&(CreateParticlesJob){
+            } else if (state->score >= 10000 && prev_score < 10000) {
+                    create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/10kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_10KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
                         .lifetime = 4
                 });
-            } else if (state.score >= 20000 && prev_score < 20000) {
-                    create_particles_job(&(CreateParticlesJob){
+            } else if (state->score >= 20000 && prev_score < 20000) {
+                    create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/20kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_20KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
                         .lifetime = 4
                 });
-            } else if (state.score >= 40000 && prev_score < 40000) {
-                    create_particles_job(&(CreateParticlesJob){
+            } else if (state->score >= 40000 && prev_score < 40000) {
+                    create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/40kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_40KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
                         .lifetime = 4
                 });
-            } else if (state.score >= 100000 && prev_score < 100000) {
-                    create_particles_job(&(CreateParticlesJob){
+            } else if (state->score >= 100000 && prev_score < 100000) {
+                    create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/100kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_100KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
                         .lifetime = 4
                 });
-            } else if (state.score >= 200000 && prev_score < 200000) {
-                    create_particles_job(&(CreateParticlesJob){
+            } else if (state->score >= 200000 && prev_score < 200000) {
+                    create_particles_job(state, &(CreateParticlesJob){
                         .variation = 3,
                         .y_vel = -2,
                         .x_vel = 3,
-                        .tex = oct_GetAsset(gBundle, "textures/200kpoints.png"),
-                        .spr = OCT_NO_ASSET,
+                        .tex = ASSET_TEX_200KPOINTS,
+                        .spr = ASSET_NONE,
                         .x = GAME_WIDTH / 2 - 120,
                         .y = 40,
                         .count = 3,
@@ -2213,54 +3935,56 @@ GameStatus game_update() {
             }
         }
 
-        if (menu_state.map == 0)
-            handle_enemy_spawns1();
-        else if (menu_state.map == 1)
-            handle_enemy_spawns2();
-        else if (menu_state.map == 2)
-            handle_enemy_spawns3();
+        profile_begin(PROFILE_PHASE_SPAWNS);
+        if (state->map == 0)
+            handle_enemy_spawns1(state);
+        else if (state->map == 1)
+            handle_enemy_spawns2(state);
+        else if (state->map == 2)
+            handle_enemy_spawns3(state);
+        profile_end(PROFILE_PHASE_SPAWNS);
     }
 
-    // particles on top for some fucking reason
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!state.particles[i].alive) continue;
-        process_particle(&state.particles[i]);
-    }
-
-    // just particles
-    oct_WaitJobs();
-
+    // particles on top for some fucking reason, physics goes wide then drawing happens here
+    profile_begin(PROFILE_PHASE_PARTICLES);
+    integrate_particles(state, gFrameAllocator);
+    const EntityPool *particles = &state->particle_pool;
+    for (int32_t i = pool_next(particles, 0); i != -1; i = pool_next(particles, i + 1))
+        process_particle(state, &state->particles[i]);
+    profile_end(PROFILE_PHASE_PARTICLES);
 
     // quit when player rip
-    if (oct_KeyPressed(OCT_KEY_SPACE) && state.player_died && state.fade_out < 0 && state.total_time - state.player_die_time > 3) {
-        state.fade_out = FADE_IN_OUT_TIME;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/stonelong.wav"),
+    if ((state->input.buttons & INPUT_CONFIRM) && state->player_died && state->fade_out < 0 && state->total_time - state->player_die_time > 3) {
+        state->fade_out = FADE_IN_OUT_TIME;
+        play_sound(
+                state, gAssets[ASSET_SND_STONELONG],
                 (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
                 false);
     }
 
     // debug
-    if (oct_KeyDown(OCT_KEY_F)) {
+    if (state->input.buttons & INPUT_QUIT) {
         return GAME_STATUS_MENU;
     }
 
-    state.fade_in -= 1;
-    state.fade_out -= 1;
-    if (state.fade_in > 0) {
-        const float percent = oct_Sirp(1, 0, state.fade_in / FADE_IN_OUT_TIME);
+    state->fade_in -= 1;
+    state->fade_out -= 1;
+    if (state->fade_in > 0 && !gHeadless) {
+        const float percent = oct_Sirp(1, 0, state->fade_in / FADE_IN_OUT_TIME);
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, 74,
-                oct_GetAsset(gBundle, "textures/curtains.png"),
+                gAssets[ASSET_TEX_CURTAINS],
                 (Oct_Vec2){GAME_WIDTH * percent, 0});
     }
-    if (state.fade_out > 0) {
-        const float percent = oct_Sirp(0, 1, state.fade_out / FADE_IN_OUT_TIME);
-        oct_DrawTextureInt(
-                OCT_INTERPOLATE_ALL, 74,
-                oct_GetAsset(gBundle, "textures/curtains.png"),
-                (Oct_Vec2){GAME_WIDTH * percent, 0});
-        if (state.fade_out <= 1) {
+    if (state->fade_out > 0) {
+        const float percent = oct_Sirp(0, 1, state->fade_out / FADE_IN_OUT_TIME);
+        if (!gHeadless) {
+            oct_DrawTextureInt(
+                    OCT_INTERPOLATE_ALL, 74,
+                    gAssets[ASSET_TEX_CURTAINS],
+                    (Oct_Vec2){GAME_WIDTH * percent, 0});
+        }
+        if (state->fade_out <= 1) {
             return GAME_STATUS_MENU;
         }
     }
@@ -2268,15 +3992,410 @@ GameStatus game_update() {
     return GAME_STATUS_PLAY_GAME;
 }
 
-void game_end() {
+void game_end(GameState *state) {
+    if (state->replay)
+        replay_between_frames(state); // the last frame doesn't get another game_update to do this
+    // one game per recording, the next game_begin would otherwise start over and save on top of it
+    if (state->replay && state->replay->mode == REPLAY_MODE_RECORDING) {
+        replay_save(state->replay);
+        state->replay->mode = REPLAY_MODE_OFF;
+    }
+}
+
+///////////////////////// SNAPSHOT /////////////////////////
+static inline void snapshot_bytes(SnapshotCursor *cursor, void *field, size_t size) {
+    if (cursor->overrun || size > (size_t)(cursor->end - cursor->at)) {
+        cursor->overrun = true;
+        return;
+    }
+    if (cursor->saving)
+        memcpy(cursor->at, field, size);
+    else
+        memcpy(field, cursor->at, size);
+    cursor->at += size;
+}
+
+// scalars and arrays of them only, a struct's padding would end up in snapshots and state hashes
+#define SNAPSHOT_FIELD(cursor, field) snapshot_bytes(cursor, &(field), sizeof(field))
+
+void sprite_slots_take(GameState *state, SpriteSlots *slots) {
+    if (gHeadless) return;
+    for (int i = 0; i < MAX_CHARACTERS; i++) {
+        slots->characters[i] = pool_alive(&state->character_pool, i) ? state->characters[i].id : 0;
+        slots->character_types[i] = state->characters[i].type;
+    }
+    for (int i = 0; i < MAX_PARTICLES; i++)
+        slots->particles[i] = pool_alive(&state->particle_pool, i) ? state->particles[i].id : 0;
+}
+
+// starts sprites for everything that wasn't in its slot (or was something else) when slots was taken,
+// whatever was there the whole time keeps animating from where it was
+void sprite_slots_refresh(GameState *state, const SpriteSlots *slots) {
+    if (gHeadless) return;
+    const EntityPool *characters = &state->character_pool;
+    for (int32_t i = pool_next(characters, 0); i != -1; i = pool_next(characters, i + 1)) {
+        Character *c = &state->characters[i];
+        if (c->id != slots->characters[i] || c->type != slots->character_types[i])
+            oct_InitSpriteInstance(&c->sprite, character_type_sprite(c), true);
+    }
+    const EntityPool *particles = &state->particle_pool;
+    for (int32_t i = pool_next(particles, 0); i != -1; i = pool_next(particles, i + 1)) {
+        Particle *p = &state->particles[i];
+        if (p->sprite_based && p->id != slots->particles[i])
+            oct_InitSpriteInstance(&p->instance, p->sprite, true);
+    }
+}
+
+// only the live part of a pool, its slots are what decide which entities come next
+static void snapshot_pool(SnapshotCursor *cursor, EntityPool *pool) {
+    snapshot_bytes(cursor, pool->alive, ((pool->capacity + 63) / 64) * sizeof(uint64_t));
+    snapshot_bytes(cursor, pool->generation, pool->capacity * sizeof(uint16_t));
+    SNAPSHOT_FIELD(cursor, pool->count);
+}
+
+// assets go in as their AssetID so they mean the same thing to any process, headless or not
+static inline void snapshot_asset(SnapshotCursor *cursor, AssetID *id, Oct_Asset *asset) {
+    uint8_t index = *id;
+    SNAPSHOT_FIELD(cursor, index);
+    if (!cursor->saving && !cursor->overrun) {
+        *id = index < ASSET_MAX ? index : ASSET_NONE;
+        *asset = asset_get(*id);
+    }
+}
+
+static void snapshot_physics(SnapshotCursor *cursor, PhysicsObject *physx) {
+    SNAPSHOT_FIELD(cursor, physx->x);
+    SNAPSHOT_FIELD(cursor, physx->y);
+    SNAPSHOT_FIELD(cursor, physx->x_vel);
+    SNAPSHOT_FIELD(cursor, physx->y_vel);
+    SNAPSHOT_FIELD(cursor, physx->noclip);
+    SNAPSHOT_FIELD(cursor, physx->bb_width);
+    SNAPSHOT_FIELD(cursor, physx->bb_height);
+}
+
+// Every field in a snapshot in order. Left out is anything that's only for looks (sprite instances,
+// the tilemap, sounds and whatever only the draw functions move along, like shown_facing), whatever
+// comes from the save file (got_highscore), anything game_begin sets up from the map (collision,
+// physx pointers) and anything rebuilt from the rest (the partition, contact list and each character's
+// contact, which update_contacts redoes before anything reads it). Dead entities aren't stored.
+// Hashing also leaves out the assets things are drawn with.
+static void snapshot_fields(GameState *state, SnapshotCursor *cursor) {
+    cursor->parts[STATE_HASH_GAME] = cursor->at;
+    SNAPSHOT_FIELD(cursor, state->lifespan);
+    SNAPSHOT_FIELD(cursor, state->max_lifespan);
+    SNAPSHOT_FIELD(cursor, state->player);
+    SNAPSHOT_FIELD(cursor, state->total_time);
+    SNAPSHOT_FIELD(cursor, state->req_kills);
+    SNAPSHOT_FIELD(cursor, state->current_kills);
+    SNAPSHOT_FIELD(cursor, state->kills);
+    SNAPSHOT_FIELD(cursor, state->req_kills_accumulator);
+    SNAPSHOT_FIELD(cursor, state->player_iframes);
+    SNAPSHOT_FIELD(cursor, state->player_died);
+    SNAPSHOT_FIELD(cursor, state->player_die_time);
+    SNAPSHOT_FIELD(cursor, state->banner_dropped);
+    SNAPSHOT_FIELD(cursor, state->frame_count);
+    SNAPSHOT_FIELD(cursor, state->game_phase);
+    SNAPSHOT_FIELD(cursor, state->seed);
+    for (int i = 0; i < RNG_STREAM_MAX; i++) {
+        SNAPSHOT_FIELD(cursor, state->rng[i].state);
+        SNAPSHOT_FIELD(cursor, state->rng[i].inc);
+    }
+    SNAPSHOT_FIELD(cursor, state->frame);
+    SNAPSHOT_FIELD(cursor, state->next_id);
+    SNAPSHOT_FIELD(cursor, state->in_tutorial);
+    SNAPSHOT_FIELD(cursor, state->score);
+    SNAPSHOT_FIELD(cursor, state->fade_in);
+    SNAPSHOT_FIELD(cursor, state->fade_out);
+    SNAPSHOT_FIELD(cursor, state->player_transform_time);
+    SNAPSHOT_FIELD(cursor, state->input.buttons);
+    SNAPSHOT_FIELD(cursor, state->input.axis_x);
+
+    // pools first so restoring knows which slots follow
+    cursor->parts[STATE_HASH_POOLS] = cursor->at;
+    snapshot_pool(cursor, &state->character_pool);
+    snapshot_pool(cursor, &state->projectile_pool);
+    snapshot_pool(cursor, &state->particle_pool);
+
+    cursor->parts[STATE_HASH_CHARACTERS] = cursor->at;
+    const EntityPool *characters = &state->character_pool;
+    for (int32_t i = pool_next(characters, 0); i != -1 && !cursor->overrun; i = pool_next(characters, i + 1)) {
+        Character *c = &state->characters[i];
+        SNAPSHOT_FIELD(cursor, c->type);
+        SNAPSHOT_FIELD(cursor, c->id);
+        SNAPSHOT_FIELD(cursor, c->facing);
+        SNAPSHOT_FIELD(cursor, c->wants_to_action);
+        SNAPSHOT_FIELD(cursor, c->action_timer);
+        SNAPSHOT_FIELD(cursor, c->direction);
+        SNAPSHOT_FIELD(cursor, c->player_controlled);
+        snapshot_physics(cursor, c->physx);
+    }
+
+    cursor->parts[STATE_HASH_PROJECTILES] = cursor->at;
+    const EntityPool *projectiles = &state->projectile_pool;
+    for (int32_t i = pool_next(projectiles, 0); i != -1 && !cursor->overrun; i = pool_next(projectiles, i + 1)) {
+        Projectile *p = &state->projectiles[i];
+        SNAPSHOT_FIELD(cursor, p->lifetime);
+        SNAPSHOT_FIELD(cursor, p->max_lifetime);
+        if (!cursor->hashing) snapshot_asset(cursor, &p->tex_id, &p->tex);
+        SNAPSHOT_FIELD(cursor, p->id);
+        SNAPSHOT_FIELD(cursor, p->player_bullet);
+        snapshot_physics(cursor, p->physx);
+    }
+
+    cursor->parts[STATE_HASH_PARTICLES] = cursor->at;
+    const EntityPool *particles = &state->particle_pool;
+    for (int32_t i = pool_next(particles, 0); i != -1 && !cursor->overrun; i = pool_next(particles, i + 1)) {
+        Particle *p = &state->particles[i];
+        if (!cursor->hashing) SNAPSHOT_FIELD(cursor, p->sprite_based);
+        SNAPSHOT_FIELD(cursor, p->lifetime);
+        SNAPSHOT_FIELD(cursor, p->total_lifetime);
+        SNAPSHOT_FIELD(cursor, p->id);
+        SNAPSHOT_FIELD(cursor, p->x_scale);
+        if (!cursor->hashing) {
+            if (p->sprite_based) snapshot_asset(cursor, &p->sprite_id, &p->sprite);
+            snapshot_asset(cursor, &p->texture_id, &p->texture);
+        }
+        SNAPSHOT_FIELD(cursor, state->particle_bodies.x[i]);
+        SNAPSHOT_FIELD(cursor, state->particle_bodies.y[i]);
+        SNAPSHOT_FIELD(cursor, state->particle_bodies.x_vel[i]);
+        SNAPSHOT_FIELD(cursor, state->particle_bodies.y_vel[i]);
+    }
+}
+
+// Writes the simulation side of state to out and returns how many bytes that took, or 0 if it
+// wouldn't fit in capacity (SNAPSHOT_MAX_SIZE always does). The header is a SNAPSHOT_HEADER_SIZE
+// byte magic, u8 version, u8 map, u8 body, u8 0, u32 size, the fields after it are in native byte
+// order.
+uint32_t snapshot_save(GameState *state, uint8_t *out, uint32_t capacity) {
+    if (capacity < SNAPSHOT_HEADER_SIZE) return 0;
+    SnapshotCursor cursor = {
+            .at = out + SNAPSHOT_HEADER_SIZE,
+            .end = out + capacity,
+            .saving = true,
+    };
+    snapshot_fields(state, &cursor);
+    if (cursor.overrun) return 0;
+
+    const uint32_t size = cursor.at - out;
+    memcpy(out, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out[4] = SNAPSHOT_VERSION;
+    out[5] = state->map;
+    out[6] = state->body;
+    out[7] = 0;
+    put_u32(out + 8, size);
+    return size;
+}
+
+// Puts state back to exactly how it was when data was saved so the game carries on the same from
+// there. state has to already be a game on the snapshot's map (from game_begin), that's what the
+// tilemap and collision come from. A replay state is using gets moved to the snapshot's frame too.
+// Returns false if data isn't a snapshot for this map, if that happened partway through restoring
+// state is garbage and needs game_begin again.
+bool snapshot_restore(GameState *state, const uint8_t *data, uint32_t size) {
+    if (size < SNAPSHOT_HEADER_SIZE || memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        data[4] != SNAPSHOT_VERSION || data[5] != state->map || data[6] >= STARTING_BODY_MAX || get_u32(data + 8) != size)
+        return false;
+
+    SpriteSlots sprites;
+    sprite_slots_take(state, &sprites);
+    SnapshotCursor cursor = {
+            .at = (uint8_t *)data + SNAPSHOT_HEADER_SIZE,
+            .end = data + size,
+    };
+    snapshot_fields(state, &cursor);
+    if (cursor.overrun || cursor.at != cursor.end) return false;
+    state->body = data[6];
+
+    // the partition comes back from where everything is now, the order objects are linked in doesn't
+    // change any results. the contact list gets built at the start of every game_update anyway.
+    partition_clear(state);
+    const EntityPool *characters = &state->character_pool;
+    for (int32_t i = pool_next(characters, 0); i != -1; i = pool_next(characters, i + 1))
+        partition_update(state, i);
+    const EntityPool *projectiles = &state->projectile_pool;
+    for (int32_t i = pool_next(projectiles, 0); i != -1; i = pool_next(projectiles, i + 1))
+        partition_update(state, MAX_CHARACTERS + i);
+
+    sprite_slots_refresh(state, &sprites);
+
+    if (state->replay)
+        replay_rewind(state->replay, state->frame);
+    return true;
+}
+
+///////////////////////// STATE HASH /////////////////////////
+// XXH64, see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t xxh_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    return xxh_rotl(acc + (input * XXH_PRIME64_2), 31) * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t v) {
+    return ((acc ^ xxh_round(0, v)) * XXH_PRIME64_1) + XXH_PRIME64_4;
+}
+
+uint64_t xxh64(const uint8_t *data, size_t size, uint64_t seed) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+        }
+        h = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += size;
+    for (; end - p >= 8; p += 8)
+        h = (xxh_rotl(h ^ xxh_round(0, xxh_read64(p)), 27) * XXH_PRIME64_1) + XXH_PRIME64_4;
+    if (end - p >= 4) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        h = (xxh_rotl(h ^ (v * XXH_PRIME64_1), 23) * XXH_PRIME64_2) + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = xxh_rotl(h ^ (*p * XXH_PRIME64_5), 11) * XXH_PRIME64_1;
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Hashes the same fields a snapshot has minus the assets, which are only for drawing, so runs can be
+// compared whichever way they were played.
+// scratch needs SNAPSHOT_MAX_SIZE bytes.
+void state_hash(GameState *state, uint8_t *scratch, StateHash *out) {
+    SnapshotCursor cursor = {
+            .at = scratch,
+            .end = scratch + SNAPSHOT_MAX_SIZE,
+            .saving = true,
+            .hashing = true,
+    };
+    snapshot_fields(state, &cursor);
+    for (int i = 0; i < STATE_HASH_MAX; i++) {
+        const uint8_t *end = i + 1 < STATE_HASH_MAX ? cursor.parts[i + 1] : cursor.at;
+        out->parts[i] = (uint32_t)xxh64(cursor.parts[i], end - cursor.parts[i], 0);
+    }
+}
+
+///////////////////////// REPLAY PLAYBACK /////////////////////////
+// game_updates with nothing drawn and no sound, for frames nobody is going to see. Stops early if
+// the game leaves play or the replay runs out.
+GameStatus game_update_unseen(GameState *state, int32_t updates) {
+    const bool headless = gHeadless;
+    SpriteSlots sprites;
+    sprite_slots_take(state, &sprites);
+    gHeadless = true;
+    GameStatus status = GAME_STATUS_PLAY_GAME;
+    for (int i = 0; i < updates && status == GAME_STATUS_PLAY_GAME && !(state->replay && replay_finished(state->replay)); i++)
+        status = game_update(state);
+    gHeadless = headless;
+    sprite_slots_refresh(state, &sprites);
+    return status;
+}
+
+// Puts state at frame (game_updates in) of the replay its playing back. Unless state is already
+// somewhere between them it starts from the last keyframe at or before frame, or the start of the
+// run if none of those restore, and plays the rest unseen.
+GameStatus replay_seek(GameState *state, int32_t frame) {
+    Replay *replay = state->replay;
+    frame = frame < 0 ? 0 : (frame > replay->count ? replay->count : frame);
+    int32_t keyframe = replay->keyframe_count - 1;
+    while (keyframe >= 0 && replay->keyframes[keyframe].frame > frame)
+        keyframe--;
+
+    if (frame < (int64_t)state->frame || (keyframe >= 0 && replay->keyframes[keyframe].frame > (int64_t)state->frame)) {
+        bool restored = false;
+        for (; keyframe >= 0 && !restored; keyframe--)
+            restored = snapshot_restore(state, replay->keyframes[keyframe].data, replay->keyframes[keyframe].size);
+        if (!restored) {
+            game_begin(state, replay->map, replay->body, replay->seed, replay);
+            replay_rewind(replay, 0);
+        }
+    }
+    return game_update_unseen(state, frame - (int32_t)state->frame);
+}
+
+// Keys for watching a replay, left and right jump back or forward REPLAY_KEYFRAME_INTERVAL frames and
+// up and down double or halve the speed. Plays all but the last of this frame's game_updates unseen,
+// the caller does that one so it gets drawn.
+GameStatus replay_viewer_update(GameState *state) {
+    Replay *replay = state->replay;
+    const int32_t speed = replay->speed > 1 ? replay->speed : 1;
+    if (oct_KeyPressed(OCT_KEY_UP))
+        replay->speed = speed * 2 < REPLAY_MAX_SPEED ? speed * 2 : REPLAY_MAX_SPEED;
+    if (oct_KeyPressed(OCT_KEY_DOWN))
+        replay->speed = speed / 2;
+
+    GameStatus status = GAME_STATUS_PLAY_GAME;
+    if (oct_KeyPressed(OCT_KEY_LEFT))
+        status = replay_seek(state, (int32_t)state->frame - REPLAY_KEYFRAME_INTERVAL);
+    else if (oct_KeyPressed(OCT_KEY_RIGHT))
+        status = replay_seek(state, (int32_t)state->frame + REPLAY_KEYFRAME_INTERVAL);
+    if (status == GAME_STATUS_PLAY_GAME && replay->speed > 1)
+        status = game_update_unseen(state, replay->speed - 1);
+    return status;
+}
 
+// where the replay is up to and how fast its going, bottom left
+void draw_replay_overlay(GameState *state) {
+    const Replay *replay = state->replay;
+    const Oct_FontAtlas font = gAssets[ASSET_FNT_MONOGRAM];
+    const int32_t at = replay->cursor / 30;
+    const int32_t length = replay->count / 30;
+    const float y = GAME_HEIGHT - 14;
+    oct_DrawTextColour(
+            font, (Oct_Vec2){5, y}, &(Oct_Colour){0, 0, 0, 1}, 1,
+            "replay %i:%02i / %i:%02i  %ix", at / 60, at % 60, length / 60, length % 60, replay->speed > 1 ? replay->speed : 1);
+    oct_DrawText(
+            font, (Oct_Vec2){4, y}, 1,
+            "replay %i:%02i / %i:%02i  %ix", at / 60, at % 60, length / 60, length % 60, replay->speed > 1 ? replay->speed : 1);
+
+    // desync stays on screen so it can be seeked back to
+    if (replay->desynced) {
+        oct_DrawTextColour(
+                font, (Oct_Vec2){4, y - 12}, &(Oct_Colour){1, 0.2, 0.2, 1}, 1,
+                "desync at frame %i (%s)", replay->desync_frame, STATE_HASH_PART_NAMES[replay->desync_part]);
+    }
 }
 
 ///////////////////////// MENU /////////////////////////
 void draw_cursor(uint64_t id, float x, float y, const char *str) {
     Oct_Vec2 text_size;
     oct_GetTextSize(
-            oct_GetAsset(gBundle, "fnt_kingdom"),
+            gAssets[ASSET_FNT_KINGDOM],
             text_size,
             1,
             "%s", str);
@@ -2305,14 +4424,14 @@ void draw_cursor(uint64_t id, float x, float y, const char *str) {
 void draw_text_fancy(uint64_t id, float x, float y, const char *str) {
     oct_DrawTextIntColour(
             OCT_INTERPOLATE_ALL, id,
-            oct_GetAsset(gBundle, "fnt_kingdom"),
+            gAssets[ASSET_FNT_KINGDOM],
             (Oct_Vec2){x + 1, y + 1},
             &(Oct_Colour){0, 0, 0, 1},
             1,
             "%s", str);
     oct_DrawTextInt(
             OCT_INTERPOLATE_ALL, id + 1,
-            oct_GetAsset(gBundle, "fnt_kingdom"),
+            gAssets[ASSET_FNT_KINGDOM],
             (Oct_Vec2){x, y},
             1,
             "%s", str);
@@ -2325,21 +4444,21 @@ void handle_top_menu() {
     }
     if (oct_KeyPressed(OCT_KEY_UP)) {
         menu_state.cursor = menu_state.cursor == 0 ? TOP_MENU_SIZE - 1 : menu_state.cursor - 1;
-        oct_PlaySound(
-                    oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                    gAssets[ASSET_SND_CURSOR],
                     (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                     false);
     }
     if (oct_KeyPressed(OCT_KEY_DOWN)) {
         menu_state.cursor = (menu_state.cursor + 1) % TOP_MENU_SIZE;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_CURSOR],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
     }
     if (oct_KeyPressed(OCT_KEY_SPACE)) {
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/select.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_SELECT],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
 
@@ -2367,21 +4486,21 @@ void handle_settings() {
     }
     if (oct_KeyPressed(OCT_KEY_UP)) {
         menu_state.cursor = menu_state.cursor == 0 ? OPTIONS_MENU_SIZE - 1 : menu_state.cursor - 1;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_CURSOR],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
     }
     if (oct_KeyPressed(OCT_KEY_DOWN)) {
         menu_state.cursor = (menu_state.cursor + 1) % OPTIONS_MENU_SIZE;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_CURSOR],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
     }
     if (oct_KeyPressed(OCT_KEY_SPACE)) {
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/select.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_SELECT],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
 
@@ -2445,29 +4564,29 @@ void handle_play() {
     }
     if (oct_KeyPressed(OCT_KEY_UP)) {
         menu_state.cursor = menu_state.cursor == 0 ? PLAY_MENU_SIZE - 1 : menu_state.cursor - 1;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_CURSOR],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
     }
     if (oct_KeyPressed(OCT_KEY_DOWN)) {
         menu_state.cursor = (menu_state.cursor + 1) % PLAY_MENU_SIZE;
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/cursor.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_CURSOR],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
     }
     if (oct_KeyPressed(OCT_KEY_SPACE)) {
-        oct_PlaySound(
-                oct_GetAsset(gBundle, "sounds/select.wav"),
+        play_sound(null, 
+                gAssets[ASSET_SND_SELECT],
                 (Oct_Vec2){0.8 * gSoundVolume, 0.8 * gSoundVolume},
                 false);
 
         if (menu_state.cursor == 0 && menu_state.fade_out < 0)  { // play
             if (highscore_reaches_x(MAP_UNLOCK_SCORES[menu_state.map])) {
                 menu_state.fade_out = FADE_IN_OUT_TIME;
-                oct_PlaySound(
-                        oct_GetAsset(gBundle, "sounds/stonelong.wav"),
+                play_sound(null, 
+                        gAssets[ASSET_SND_STONELONG],
                         (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
                         false);
             } else {
@@ -2490,26 +4609,26 @@ void handle_play() {
     if (menu_state.character == STARTING_BODY_Y_SHOOTER) {
         const float gun_x = character_x + 6 - (19 / 2);
         oct_DrawSpriteFrame(
-                oct_GetAsset(gBundle, "sprites/playershooter.json"), 0,
+                gAssets[ASSET_SPR_PLAYERSHOOTER], 0,
                 (Oct_Vec2) {character_x, character_y});
         oct_DrawTextureExt(
-                oct_GetAsset(gBundle, "textures/ygun.png"),
+                gAssets[ASSET_TEX_YGUN],
                 (Oct_Vec2) {gun_x, character_y - 23},
                 (Oct_Vec2) {1, 1},
                 0, (Oct_Vec2) {0, 0});
     } else {
         oct_DrawSpriteFrame(
-                oct_GetAsset(gBundle, "sprites/playerjumper.json"), 0,
+                gAssets[ASSET_SPR_PLAYERJUMPER], 0,
                 (Oct_Vec2) {character_x, character_y});
     }
 
     const Oct_Texture maps[] = {
-            oct_GetAsset(gBundle, "textures/map1.png"),
-            oct_GetAsset(gBundle, "textures/map2.png"),
-            oct_GetAsset(gBundle, "textures/map3.png"),
+            gAssets[ASSET_TEX_MAP1],
+            gAssets[ASSET_TEX_MAP2],
+            gAssets[ASSET_TEX_MAP3],
     };
     oct_DrawText(
-            oct_GetAsset(gBundle, "fnt_monogram"),
+            gAssets[ASSET_FNT_MONOGRAM],
             (Oct_Vec2){150, 110},
             1,
             "   Body              Map");
@@ -2521,12 +4640,12 @@ void handle_play() {
 
     if (!highscore_reaches_x(MAP_UNLOCK_SCORES[menu_state.map])) {
         oct_DrawTextureExt(
-                oct_GetAsset(gBundle, "textures/locked.png"),
+                gAssets[ASSET_TEX_LOCKED],
                 (Oct_Vec2){GAME_WIDTH / 2 + 30, GAME_HEIGHT / 2 + 20},
                 (Oct_Vec2){1, 1},
                 0, (Oct_Vec2){OCT_ORIGIN_MIDDLE, OCT_ORIGIN_MIDDLE});
         oct_DrawText(
-                oct_GetAsset(gBundle, "fnt_monogram"),
+                gAssets[ASSET_FNT_MONOGRAM],
                 (Oct_Vec2){240 - 9, 110 + 96},
                 1,
                 "Reach %i points", (int)MAP_UNLOCK_SCORES[menu_state.map]);
@@ -2536,7 +4655,7 @@ void handle_play() {
         snprintf(buf, 99, "Highscore: %i", (int)menu_state.highscore[menu_state.map]);
         float size = strlen(buf) * 7;
         oct_DrawText(
-                oct_GetAsset(gBundle, "fnt_monogram"),
+                gAssets[ASSET_FNT_MONOGRAM],
                 (Oct_Vec2){roundf(294 - (size / 2)), 110 + 96}, 1,
                 "Highscore: %i", (int)menu_state.highscore[menu_state.map]);
     }
@@ -2556,12 +4675,12 @@ void menu_begin() {
         oct_StopSound(gPlayingMusic);
     }
     fuck = true;
-    gPlayingMusic = oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/title.ogg"),
+    gPlayingMusic = play_sound(null, 
+            gAssets[ASSET_SND_TITLE],
             (Oct_Vec2){GLOBAL_MUSIC_VOLUME * gMusicVolume, GLOBAL_MUSIC_VOLUME * gMusicVolume},
             true);
-    oct_PlaySound(
-            oct_GetAsset(gBundle, "sounds/stoneshort.wav"),
+    play_sound(null, 
+            gAssets[ASSET_SND_STONESHORT],
             (Oct_Vec2){1 * gSoundVolume, 1 * gSoundVolume},
             false);
 }
@@ -2569,8 +4688,8 @@ void menu_begin() {
 GameStatus menu_update() {
     // moving bg
     const float x = gFrameCounter % (int)GAME_WIDTH;
-    oct_DrawTexture(oct_GetAsset(gBundle, "textures/menubg.png"), (Oct_Vec2){x - GAME_WIDTH, 0});
-    oct_DrawTexture(oct_GetAsset(gBundle, "textures/menubg.png"), (Oct_Vec2){x, 0});
+    oct_DrawTexture(gAssets[ASSET_TEX_MENUBG], (Oct_Vec2){x - GAME_WIDTH, 0});
+    oct_DrawTexture(gAssets[ASSET_TEX_MENUBG], (Oct_Vec2){x, 0});
 
     if (menu_state.menu == MENU_INDEX_TOP)
         handle_top_menu();
@@ -2600,13 +4719,13 @@ GameStatus menu_update() {
 
     oct_DrawTextureInt(
             OCT_INTERPOLATE_ALL, 87,
-            oct_GetAsset(gBundle, "textures/copyright.png"),
+            gAssets[ASSET_TEX_COPYRIGHT],
             (Oct_Vec2){408, 17 + (sin(oct_Time()) * 4)});
 
     // 212 draw little dude
     static Oct_SpriteInstance instance;
     static bool started = false;
-    const Oct_Sprite spr = oct_GetAsset(gBundle, "sprites/laser.json");
+    const Oct_Sprite spr = gAssets[ASSET_SPR_LASER];
     if (!started) {
         oct_InitSpriteInstance(&instance, spr, true);
         started = true;
@@ -2614,13 +4733,13 @@ GameStatus menu_update() {
     oct_DrawSpriteExt(spr, &instance, (Oct_Vec2){400, 212}, (Oct_Vec2){-1, 1}, 0, (Oct_Vec2){0, 0});
 
     oct_DrawTextureExt(
-            oct_GetAsset(gBundle, "textures/title.png"),
+            gAssets[ASSET_TEX_TITLE],
             (Oct_Vec2){GAME_WIDTH / 2 - 40, 40},
             (Oct_Vec2){1, 1},
             0, (Oct_Vec2){OCT_ORIGIN_MIDDLE, OCT_ORIGIN_MIDDLE});
 
     oct_DrawTexture(
-            oct_GetAsset(gBundle, "textures/controls.png"),
+            gAssets[ASSET_TEX_CONTROLS],
             (Oct_Vec2){445, 235});
 
     menu_state.fade_in -= 1;
@@ -2629,14 +4748,14 @@ GameStatus menu_update() {
         const float percent = oct_Sirp(1, 0, menu_state.fade_in / FADE_IN_OUT_TIME);
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, 74,
-                oct_GetAsset(gBundle, "textures/curtains.png"),
+                gAssets[ASSET_TEX_CURTAINS],
                 (Oct_Vec2){GAME_WIDTH * percent, 0});
     }
     if (menu_state.fade_out > 0) {
         const float percent = oct_Sirp(0, 1, menu_state.fade_out / FADE_IN_OUT_TIME);
         oct_DrawTextureInt(
                 OCT_INTERPOLATE_ALL, 74,
-                oct_GetAsset(gBundle, "textures/curtains.png"),
+                gAssets[ASSET_TEX_CURTAINS],
                 (Oct_Vec2){GAME_WIDTH * percent, 0});
         if (menu_state.fade_out == 1) {
             return GAME_STATUS_PLAY_GAME;
@@ -2652,6 +4771,215 @@ void menu_end() {
 
 }
 
+///////////////////////// BATCH /////////////////////////
+void headless_init();
+
+// logical cores, C has no portable way to ask so its whatever the os says
+int32_t cpu_count() {
+#ifdef _WIN32
+    const char *count = getenv("NUMBER_OF_PROCESSORS");
+    return count && atoi(count) > 0 ? atoi(count) : 1;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+
+// next job from the front of a worker's own queue, -1 if its empty
+static int32_t batch_pop(BatchQueue *queue) {
+    uint64_t range = atomic_load(&queue->range);
+    while ((uint32_t)range < (uint32_t)(range >> 32)) {
+        if (atomic_compare_exchange_weak(&queue->range, &range, range + 1))
+            return (int32_t)(uint32_t)range;
+    }
+    return -1;
+}
+
+// last job off the back of someone else's queue, -1 if its empty
+static int32_t batch_steal(BatchQueue *queue) {
+    uint64_t range = atomic_load(&queue->range);
+    while ((uint32_t)range < (uint32_t)(range >> 32)) {
+        if (atomic_compare_exchange_weak(&queue->range, &range, range - (1ULL << 32)))
+            return (int32_t)(range >> 32) - 1;
+    }
+    return -1;
+}
+
+// Plays one job on state and fills in its result. Nothing about the score, kills or survival time
+// changes once the player is dead (and nobody at the controls can't leave the death screen) so
+// every run stops there.
+void batch_run(GameState *state, const BatchJob *job, int32_t frames, BatchResult *result) {
+    Replay replay = {0};
+    StartingMap map = job->map;
+    StartingBody body = job->body;
+    uint64_t seed = job->seed;
+    if (job->replay[0]) {
+        replay.mode = REPLAY_MODE_PLAYING;
+        replay.filename = job->replay;
+        if (!replay_load(&replay, false)) {
+            *result = (BatchResult){.failed = true, .desync_frame = -1};
+            replay_free(&replay);
+            return;
+        }
+        map = replay.map;
+        body = replay.body;
+        seed = replay.seed;
+    }
+    game_begin(state, map, body, seed, &replay);
+
+    const uint64_t start = clock_ns();
+    int32_t frame = 0;
+    GameStatus status = GAME_STATUS_PLAY_GAME;
+    while (frame < frames && status == GAME_STATUS_PLAY_GAME && !state->player_died && !replay_finished(&replay)) {
+        status = game_update(state);
+        frame++;
+    }
+    const double elapsed = fmax((clock_ns() - start) / 1e9, 1e-9);
+    game_end(state);
+
+    *result = (BatchResult){
+        .map = map,
+        .body = body,
+        .seed = seed,
+        .frames = frame,
+        .score = state->score,
+        .survived = state->player_died ? state->player_die_time : state->total_time,
+        .phase = state->game_phase,
+        .kills = state->kills,
+        .fps = frame / elapsed,
+        .desync_frame = replay.desynced ? replay.desync_frame : -1,
+        .desync_part = replay.desync_part,
+    };
+    replay_free(&replay);
+}
+
+// Takes jobs off its own queue until its empty then steals from the others, nothing gets added
+// once the batch starts so when every queue is empty its done
+int batch_worker(void *data) {
+    const BatchWorker *worker = data;
+    Batch *batch = worker->batch;
+    gAllocator = oct_CreateHeapAllocator();
+    GameState *state = oct_Malloc(gAllocator, sizeof(struct GameState_t));
+
+    for (;;) {
+        int32_t job = batch_pop(&batch->queues[worker->index]);
+        for (int32_t i = 1; job == -1 && i < batch->workers; i++)
+            job = batch_steal(&batch->queues[(worker->index + i) % batch->workers]);
+        if (job == -1) break;
+        batch_run(state, &batch->jobs[job], batch->frames, &batch->results[job]);
+    }
+
+    oct_Free(gAllocator, state);
+    oct_FreeAllocator(gAllocator);
+    return 0;
+}
+
+// Reads one job per line, either "<map 1-3> <jumper|shooter> <seed>" or "replay <file>". Blank
+// lines and lines starting with # are skipped. Returns how many were put in jobs.
+int32_t batch_load_jobs(const char *filename, BatchJob **jobs) {
+    FILE *file = fopen(filename, "r");
+    if (!file)
+        oct_Raise(OCT_STATUS_FILE_DOES_NOT_EXIST, true, "no batch file %s", filename);
+
+    int32_t count = 0;
+    int32_t capacity = 0;
+    char line[512];
+    for (int32_t number = 1; fgets(line, sizeof(line), file); number++) {
+        BatchJob job = {0};
+        char first[2];
+        char body[16];
+        int32_t map;
+        unsigned long long seed;
+        if (sscanf(line, " %1s", first) != 1 || first[0] == '#') continue;
+        if (sscanf(line, " replay %259s", job.replay) == 1) {
+            // map, body and seed come from the replay
+        } else if (sscanf(line, "%i %15s %llu", &map, body, &seed) == 3) {
+            job.map = oct_Clamp(1, STARTING_MAP_MAX, map) - 1;
+            job.body = strcmp(body, "shooter") == 0 ? STARTING_BODY_Y_SHOOTER : STARTING_BODY_JUMPER;
+            job.seed = seed;
+        } else {
+            oct_Raise(OCT_STATUS_ERROR, true, "%s:%i isn't a batch job", filename, number);
+        }
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            *jobs = oct_Realloc(gAllocator, *jobs, capacity * sizeof(BatchJob));
+        }
+        (*jobs)[count++] = job;
+    }
+    fclose(file);
+    return count;
+}
+
+// Runs every job in jobs_file headless on workers threads (0 for one per core), frames at most
+// each, and writes a csv row per job in the order they're listed to out (stdout if its null)
+int run_batch(const char *jobs_file, const char *out, int32_t workers, int32_t frames) {
+    gAllocator = oct_CreateHeapAllocator();
+    headless_init();
+    BatchJob *jobs = null;
+    const int32_t count = batch_load_jobs(jobs_file, &jobs);
+    workers = oct_Clamp(1, BATCH_MAX_WORKERS, workers > 0 ? workers : cpu_count());
+    if (workers > count && count > 0)
+        workers = count;
+
+    // everyone starts with an even slice and whoever runs out first steals from the rest
+    BatchQueue queues[BATCH_MAX_WORKERS];
+    BatchWorker info[BATCH_MAX_WORKERS];
+    thrd_t threads[BATCH_MAX_WORKERS];
+    Batch batch = {
+            .jobs = jobs,
+            .results = oct_Malloc(gAllocator, (count > 0 ? count : 1) * sizeof(BatchResult)),
+            .count = count,
+            .frames = frames,
+            .queues = queues,
+            .workers = workers,
+    };
+    for (int32_t i = 0; i < workers; i++) {
+        const uint64_t next = ((int64_t)count * i) / workers;
+        const uint64_t end = ((int64_t)count * (i + 1)) / workers;
+        atomic_init(&queues[i].range, (end << 32) | next);
+        info[i] = (BatchWorker){.batch = &batch, .index = i};
+    }
+
+    const uint64_t start = clock_ns();
+    for (int32_t i = 0; i < workers; i++)
+        if (thrd_create(&threads[i], batch_worker, &info[i]) != thrd_success)
+            oct_Raise(OCT_STATUS_ERROR, true, "couldn't start batch worker %i", i);
+    for (int32_t i = 0; i < workers; i++)
+        thrd_join(threads[i], null);
+    const double elapsed = (clock_ns() - start) / 1e9;
+
+    FILE *file = out ? fopen(out, "w") : stdout;
+    if (!file)
+        oct_Raise(OCT_STATUS_ERROR, true, "couldn't open %s", out);
+    fprintf(file, "map,body,seed,replay,frames,score,survived,phase,kills,fps,desync_frame,desync_part,failed\n");
+    int32_t desyncs = 0;
+    int32_t failures = 0;
+    for (int32_t i = 0; i < count; i++) {
+        const BatchResult *result = &batch.results[i];
+        const bool desynced = result->desync_frame != -1;
+        if (result->failed) {
+            fprintf(file, ",,,%s,,,,,,,,,1\n", jobs[i].replay);
+            failures++;
+            continue;
+        }
+        fprintf(file, "%i,%s,%llu,%s,%i,%.0f,%.2f,%i,%i,%.1f,%i,%s,0\n",
+                result->map + 1, result->body == STARTING_BODY_Y_SHOOTER ? "shooter" : "jumper",
+                (unsigned long long)result->seed, jobs[i].replay, result->frames, result->score,
+                result->survived, result->phase, result->kills, result->fps,
+                result->desync_frame, desynced ? STATE_HASH_PART_NAMES[result->desync_part] : "");
+        desyncs += desynced;
+    }
+    if (out)
+        fclose(file);
+    fprintf(stderr, "%i runs on %i threads in %.2fs, %i desynced, %i failed\n", count, workers, elapsed, desyncs, failures);
+
+    oct_Free(gAllocator, batch.results);
+    oct_Free(gAllocator, jobs);
+    oct_FreeAllocator(gAllocator);
+    return desyncs > 0 || failures > 0; // so a corpus of replays can gate a build
+}
+
 ///////////////////////// MAIN /////////////////////////
 
 // parses save file, returning reasonable defaults if it doesnt exist 
@@ -2730,8 +5058,12 @@ void *startup() {
     } else {
         gBundle = oct_LoadAssetBundle("data");
     }
+    for (int i = 0; i < ASSET_MAX; i++)
+        gAssets[i] = oct_GetAsset(gBundle, ASSET_NAMES[i]);
     gAllocator = oct_CreateHeapAllocator();
     gFrameAllocator = oct_CreateArenaAllocator(4096);
+    if (gReplay.mode == REPLAY_MODE_PLAYING)
+        replay_load(&gReplay, true);
 
     // Backbuffer
     gBackBuffer = oct_CreateSurface((Oct_Vec2){GAME_WIDTH, GAME_HEIGHT});
@@ -2753,25 +5085,46 @@ void *startup() {
 // Called each logical frame, whatever you return is passed to either the next update or shutdown
 void *update(void *ptr) {
     static bool in_menu = true;
+    profile_begin(PROFILE_PHASE_FRAME);
+    if (oct_KeyPressed(OCT_KEY_F3))
+        gProfiler.overlay = !gProfiler.overlay;
 
     // Use backbuffer
     oct_SetDrawTarget(gBackBuffer);
     oct_DrawClear(&(Oct_Colour){195.0 / 255.0, 209.0 / 255.0, 234.0 / 255.0, 1});
 
     if (in_menu) {
-        const GameStatus status = menu_update();
+        // replays skip the menu and go straight into the game
+        const GameStatus status = gReplay.mode == REPLAY_MODE_PLAYING ? GAME_STATUS_PLAY_GAME : menu_update();
         if (status == GAME_STATUS_PLAY_GAME) {
             in_menu = false;
             menu_end();
-            game_begin();
+            const bool playing = gReplay.mode == REPLAY_MODE_PLAYING;
+            if (playing) {
+                menu_state.map = gReplay.map;
+                menu_state.character = gReplay.body;
+            }
+            game_begin(&game_state, menu_state.map, menu_state.character, playing ? gReplay.seed : clock_ns(), &gReplay);
+            if (playing && gReplay.start_frame > 0)
+                replay_seek(&game_state, gReplay.start_frame);
         } else if (status == GAME_STATUS_QUIT) {
             abort();
         }
     } else {
-        const GameStatus status = game_update();
+        // watching a replay can run more than one game_update a frame, only the last gets drawn
+        const bool watching = gReplay.mode == REPLAY_MODE_PLAYING;
+        GameStatus status = watching ? replay_viewer_update(&game_state) : GAME_STATUS_PLAY_GAME;
+        if (status == GAME_STATUS_PLAY_GAME)
+            status = game_update(&game_state);
+        if (watching)
+            draw_replay_overlay(&game_state);
+        if (replay_finished(&gReplay)) { // back to normal play after
+            gReplay.mode = REPLAY_MODE_OFF;
+            status = GAME_STATUS_MENU;
+        }
         if (status == GAME_STATUS_MENU) {
             in_menu = true;
-            game_end();
+            game_end(&game_state);
             menu_begin();
         } else if (status == GAME_STATUS_QUIT) {
             abort();
@@ -2781,6 +5134,7 @@ void *update(void *ptr) {
     oct_SetDrawTarget(OCT_NO_ASSET);
 
     // Draw backbuffer
+    profile_begin(PROFILE_PHASE_BLIT);
     const float window_width = oct_WindowWidth();
     const float window_height = oct_WindowHeight();
     if (!gPixelPerfect) {
@@ -2806,7 +5160,11 @@ void *update(void *ptr) {
                 0,
                 (Oct_Vec2) {0, 0});
     }
+    profile_end(PROFILE_PHASE_BLIT);
+    draw_profiler();
 
+    profile_end(PROFILE_PHASE_FRAME);
+    profile_frame_end();
     gFrameCounter++;
     oct_ResetAllocator(gFrameAllocator);
     return null;
@@ -2814,12 +5172,145 @@ void *update(void *ptr) {
 
 // Called once when the engine is about to be deinitialized
 void shutdown(void *ptr) {
+    // still recording means the window was closed mid game, game_end never got to save it
+    if (gReplay.mode == REPLAY_MODE_RECORDING && gReplay.count > 0)
+        replay_save(&gReplay);
     oct_FreeAllocator(gAllocator);
     oct_FreeAllocator(gFrameAllocator);
     oct_FreeAssetBundle(gBundle);
+    profile_close_csv();
+}
+
+// Switches the process to running games without a window, renderer or audio. Nothing is loaded
+// from the bundle so anything headless has to work without assets.
+void headless_init() {
+    gHeadless = true;
+    for (int i = 0; i < ASSET_MAX; i++)
+        gAssets[i] = OCT_NO_ASSET;
+}
+
+void headless_begin(GameState *state, StartingMap map, StartingBody body, uint64_t seed, Replay *replay) {
+    headless_init();
+    game_begin(state, map, body, seed, replay);
 }
 
+// Runs game_update for up to frames frames as fast as possible and prints a summary
+int run_headless(int32_t frames, StartingMap map, StartingBody body, uint64_t seed) {
+    GameState *state = &game_state;
+    gAllocator = oct_CreateHeapAllocator();
+    gFrameAllocator = oct_CreateArenaAllocator(4096);
+    if (gReplay.mode == REPLAY_MODE_PLAYING) {
+        replay_load(&gReplay, true);
+        map = gReplay.map;
+        body = gReplay.body;
+        seed = gReplay.seed;
+    }
+    headless_begin(state, map, body, seed, &gReplay);
+    if (gReplay.mode == REPLAY_MODE_PLAYING && gReplay.start_frame > 0)
+        replay_seek(state, gReplay.start_frame);
+
+    const uint64_t start = clock_ns();
+    int32_t frame = 0;
+    GameStatus status = GAME_STATUS_PLAY_GAME;
+    while (frame < frames && status == GAME_STATUS_PLAY_GAME && !replay_finished(&gReplay)) {
+        profile_begin(PROFILE_PHASE_FRAME);
+        status = game_update(state);
+        profile_end(PROFILE_PHASE_FRAME);
+        profile_frame_end();
+        gFrameCounter++;
+        frame++;
+        oct_ResetAllocator(gFrameAllocator);
+    }
+    const double elapsed = fmax((clock_ns() - start) / 1e9, 1e-9);
+    const bool recorded = gReplay.mode == REPLAY_MODE_RECORDING;
+    game_end(state);
+
+    printf("seed:        %llu\n", (unsigned long long)seed);
+    printf("frames:      %i (%.1fs of game time)\n", frame, frame / 30.0);
+    if (gReplay.mode == REPLAY_MODE_PLAYING)
+        printf("replay:      %s, %i of %i frames\n", gReplay.filename, gReplay.cursor, gReplay.count);
+    if (gReplay.desynced)
+        printf("hashes:      desynced at frame %i in the %s\n", gReplay.desync_frame, STATE_HASH_PART_NAMES[gReplay.desync_part]);
+    else if (gReplay.mode == REPLAY_MODE_PLAYING && gReplay.hash_count > 0)
+        printf("hashes:      all %i matched\n", gReplay.hash_count < gReplay.cursor + 1 ? gReplay.hash_count : gReplay.cursor + 1);
+    else if (recorded && gReplay.hashing)
+        printf("hashes:      %i recorded\n", gReplay.hash_count);
+    printf("fps:         %.1f (%.4f ms/frame)\n", frame / elapsed, (elapsed * 1000) / frame);
+    printf("score:       %.0f (phase %i)\n", state->score, state->game_phase);
+    if (state->player_died)
+        printf("player:      died at %.1fs\n", state->player_die_time);
+    else
+        printf("player:      alive\n");
+    printf("characters:  %i\n", state->character_pool.count);
+    printf("projectiles: %i\n", state->projectile_pool.count);
+    printf("particles:   %i\n", state->particle_pool.count);
+    printf("sounds:      %llu\n", (unsigned long long)state->sounds);
+    printf("\n%-12s %7s %7s %7s  (ms, last %i frames)\n", "phase", "min", "avg", "p99", gProfiler.count);
+    for (int i = 0; i < PROFILE_PHASE_MAX; i++) {
+        const ProfileStats stats = profile_stats(i);
+        printf("%-12s %7.3f %7.3f %7.3f\n", PROFILE_PHASE_NAMES[i], stats.min, stats.avg, stats.p99);
+    }
+
+    profile_close_csv();
+    oct_FreeAllocator(gAllocator);
+    oct_FreeAllocator(gFrameAllocator);
+    return gReplay.desynced;
+}
+
+#ifndef JAMGAME_BENCHMARK
 int main(int argc, const char **argv) {
+    // jamgame [--headless <frames>] [--map 1-3] [--body jumper|shooter] [--seed <n>] [--profile-csv <file>]
+    //         [--record <file> [--hash]] [--replay <file> [--seek <seconds>] [--speed <1-64>]]
+    // jamgame --batch <jobs file> [--out <csv>] [--threads <n>] [--frames <n>]
+    bool headless = false;
+    const char *batch = null;
+    const char *out = null;
+    int32_t threads = 0;
+    int32_t batch_frames = BATCH_DEFAULT_FRAMES;
+    int32_t frames = 0;
+    uint64_t seed = clock_ns();
+    StartingMap map = STARTING_MAP_1;
+    StartingBody body = STARTING_BODY_JUMPER;
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--headless") == 0 && has_value) {
+            headless = true;
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--map") == 0 && has_value) {
+            map = oct_Clamp(1, STARTING_MAP_MAX, atoi(argv[++i])) - 1;
+        } else if (strcmp(argv[i], "--body") == 0 && has_value) {
+            body = strcmp(argv[++i], "shooter") == 0 ? STARTING_BODY_Y_SHOOTER : STARTING_BODY_JUMPER;
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            seed = strtoull(argv[++i], null, 10);
+        } else if (strcmp(argv[i], "--profile-csv") == 0 && has_value) {
+            profile_open_csv(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+            gReplay.mode = REPLAY_MODE_RECORDING;
+            gReplay.filename = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+            gReplay.mode = REPLAY_MODE_PLAYING;
+            gReplay.filename = argv[++i];
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            gReplay.hashing = true;
+        } else if (strcmp(argv[i], "--seek") == 0 && has_value) {
+            gReplay.start_frame = atof(argv[++i]) * 30;
+        } else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            gReplay.speed = oct_Clamp(1, REPLAY_MAX_SPEED, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+            batch = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            batch_frames = atoi(argv[++i]);
+        }
+    }
+    if (batch)
+        return run_batch(batch, out, threads, batch_frames > 0 ? batch_frames : BATCH_DEFAULT_FRAMES);
+    if (headless)
+        return run_headless(frames > 0 ? frames : (gReplay.mode == REPLAY_MODE_PLAYING ? INT32_MAX : 1), map, body, seed);
+
     Oct_InitInfo initInfo = {
             .sType = OCT_STRUCTURE_TYPE_INIT_INFO,
             .startup = startup,
@@ -2837,3 +5328,160 @@ int main(int argc, const char **argv) {
     oct_Init(&initInfo);
     return 0;
 }
+#endif // JAMGAME_BENCHMARK
+
+///////////////////////// BENCHMARK /////////////////////////
+#ifdef JAMGAME_BENCHMARK
+// Scripted worst cases for the simulation core, run headless by the jamgame_bench target
+typedef struct BenchScenario_t {
+    const char *name;
+    StartingMap map;
+    uint64_t seed;
+    void (*step)(GameState *state); // called before every game_update to keep the load up
+} BenchScenario;
+
+const int32_t BENCH_WARMUP_FRAMES = 60; // not timed, lets the scenario fill up
+
+// nobody is at the controls so keep the player from dying and ending up on the death screen
+static void bench_keep_player_alive(GameState *state) {
+    state->lifespan = PLAYER_STARTING_LIFESPAN;
+    state->player_iframes = PLAYER_I_FRAMES;
+}
+
+// tops the character pool back up with dashers every frame, they punch most of each other out by the
+// end of it so every frame starts with MAX_CHARACTERS
+void bench_step_dashers(GameState *state) {
+    bench_keep_player_alive(state);
+    while (add_ai(state, CHARACTER_TYPE_DASHER));
+}
+
+// a full projectile pool bouncing around the level
+void bench_step_projectiles(GameState *state) {
+    bench_keep_player_alive(state);
+    for (int attempts = 0; attempts < 50 && state->projectile_pool.count < MAX_PROJECTILES; attempts++) {
+        create_projectile(
+                state, false, ASSET_TEX_BULLET, 10,
+                rng_float(state, RNG_STREAM_SPAWN, 16, GAME_WIDTH - 16), rng_float(state, RNG_STREAM_SPAWN, 16, GAME_HEIGHT - 16),
+                rng_float(state, RNG_STREAM_SPAWN, -SPEED_LIMIT, SPEED_LIMIT), rng_float(state, RNG_STREAM_SPAWN, -SPEED_LIMIT, SPEED_LIMIT));
+    }
+}
+
+// a bomber going off every frame in a crowd of jumpers, keeps the particle pool about full
+void bench_step_explosions(GameState *state) {
+    bench_keep_player_alive(state);
+    for (int i = 0; i < 20 && state->character_pool.count < 30; i++)
+        add_ai(state, CHARACTER_TYPE_JUMPER);
+
+    Character *bomber = add_ai(state, CHARACTER_TYPE_BOMBER);
+    if (bomber) {
+        bomber->physx->x = rng_float(state, RNG_STREAM_SPAWN, 32, GAME_WIDTH - 32);
+        bomber->physx->y = rng_float(state, RNG_STREAM_SPAWN, 32, GAME_HEIGHT - 32);
+        blow_up(state, bomber);
+        kill_character(state, false, bomber, false);
+    }
+}
+
+const BenchScenario BENCH_SCENARIOS[] = {
+        {"dashers", STARTING_MAP_1, 1, bench_step_dashers},
+        {"projectiles", STARTING_MAP_1, 2, bench_step_projectiles},
+        {"explosions", STARTING_MAP_1, 3, bench_step_explosions},
+};
+const int32_t BENCH_SCENARIO_COUNT = sizeof(BENCH_SCENARIOS) / sizeof(BENCH_SCENARIOS[0]);
+
+// Puts a body with its edge exactly on the boundary of every wall tile on the map that has room beside
+// it and sweeps it into the wall, collision_at counts that edge as inside the wall so it can't move.
+// Returns how many moved.
+int32_t bench_check_sweeps(GameState *state, int32_t *cases) {
+    int32_t failed = 0;
+    for (int32_t row = 0; row < LEVEL_HEIGHT; row++) {
+        for (int32_t col = 0; col < LEVEL_WIDTH; col++) {
+            if (!(level_tile(state, col, row) & TILE_FLAG_SOLID)) continue;
+            for (int32_t step = -1; step <= 1; step += 2) {
+                if (level_tile(state, col - step, row) & TILE_FLAG_SOLID) continue;
+                const PhysicsObject physx = {
+                        .x = step > 0 ? (col * TILE_SIZE) - 12 : (col + 1) * TILE_SIZE,
+                        .y = (row * TILE_SIZE) + 2,
+                        .bb_width = 12,
+                        .bb_height = 12,
+                };
+                const SweepResult sweep = sweep_axis(state, null, null, &physx, step * 4, false);
+                failed += step > 0 ? sweep.position > physx.x : sweep.position < physx.x;
+                (*cases)++;
+            }
+        }
+    }
+    return failed;
+}
+
+// jamgame_bench [frames]
+int main(int argc, const char **argv) {
+    const int32_t frames = argc > 1 && atoi(argv[1]) > 0 ? atoi(argv[1]) : 1000;
+    GameState *state = &game_state;
+    gAllocator = oct_CreateHeapAllocator();
+    gFrameAllocator = oct_CreateArenaAllocator(4096);
+
+    int32_t sweep_cases = 0;
+    int32_t sweep_failures = 0;
+    for (StartingMap map = 0; map < STARTING_MAP_MAX; map++) {
+        headless_begin(state, map, STARTING_BODY_JUMPER, 1, null);
+        sweep_failures += bench_check_sweeps(state, &sweep_cases);
+    }
+    printf("sweeps into walls from exactly on a tile boundary: %i of %i moved\n\n", sweep_failures, sweep_cases);
+
+    uint8_t *snapshot = oct_Malloc(gAllocator, SNAPSHOT_MAX_SIZE);
+    printf("%-12s %8s %12s %12s %14s %6s %6s %6s %10s %10s %10s\n", "scenario", "frames", "ns/frame", "p99 ns", "tests/frame", "chars", "proj", "parts", "snap bytes", "save ns", "restore ns");
+    for (int i = 0; i < BENCH_SCENARIO_COUNT; i++) {
+        const BenchScenario *scenario = &BENCH_SCENARIOS[i];
+        headless_begin(state, scenario->map, STARTING_BODY_JUMPER, scenario->seed, null);
+        for (int frame = 0; frame < BENCH_WARMUP_FRAMES; frame++) {
+            scenario->step(state);
+            game_update(state);
+            oct_ResetAllocator(gFrameAllocator);
+        }
+
+        memset(&gProfiler, 0, sizeof(struct Profiler_t));
+        state->collision_tests = 0;
+        uint64_t total = 0;
+        double characters = 0, projectiles = 0, particles = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            profile_begin(PROFILE_PHASE_FRAME);
+            const uint64_t start = clock_ns();
+            scenario->step(state);
+            // what the frame has to simulate, the step tops these up and the update can empty them again
+            characters += state->character_pool.count;
+            projectiles += state->projectile_pool.count;
+            particles += state->particle_pool.count;
+            game_update(state);
+            total += clock_ns() - start;
+            profile_end(PROFILE_PHASE_FRAME);
+            profile_frame_end();
+            oct_ResetAllocator(gFrameAllocator);
+        }
+
+        // snapshotting the scenario as it ended up, restoring it puts the same state back each time
+        uint32_t snapshot_size = 0;
+        const uint64_t save_start = clock_ns();
+        for (int frame = 0; frame < frames; frame++)
+            snapshot_size = snapshot_save(state, snapshot, SNAPSHOT_MAX_SIZE);
+        const uint64_t save_total = clock_ns() - save_start;
+        const uint64_t restore_start = clock_ns();
+        for (int frame = 0; frame < frames; frame++)
+            snapshot_restore(state, snapshot, snapshot_size);
+        const uint64_t restore_total = clock_ns() - restore_start;
+
+        printf("%-12s %8i %12.0f %12.0f %14.1f %6.0f %6.0f %6.0f %10u %10.0f %10.0f\n",
+               scenario->name, frames,
+               (double)total / frames,
+               profile_stats(PROFILE_PHASE_FRAME).p99 * 1e6,
+               (double)state->collision_tests / frames,
+               characters / frames, projectiles / frames, particles / frames,
+               snapshot_size, (double)save_total / frames, (double)restore_total / frames);
+    }
+
+    oct_Free(gAllocator, snapshot);
+
+    oct_FreeAllocator(gAllocator);
+    oct_FreeAllocator(gFrameAllocator);
+    return sweep_failures > 0;
+}
+#endif // JAMGAME_BENCHMARK